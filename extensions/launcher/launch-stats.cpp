@@ -0,0 +1,156 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#include "launch-stats.h"
+
+#include <glib.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <vector>
+
+#include "../../src/components/hyprland.h"
+#include "../../src/utils.h"
+
+namespace LaunchStats {
+constexpr int64_t timeout = 30 * G_USEC_PER_SEC;
+// Recent samples per app.
+constexpr size_t maxSamples = 32;
+// Launches awaiting window, oldest dropped beyond.
+constexpr size_t maxPending = 32;
+
+struct Pending {
+  std::string app;
+  int64_t launchTime;
+};
+std::map<pid_t, Pending> pending;
+
+struct Stats {
+  uint count = 0;
+  std::vector<int64_t> latencies;
+  std::vector<int64_t> hideTimes;
+};
+std::map<std::string, Stats> stats;
+
+uint listener = 0;
+
+struct HyprlandClient {
+  std::string address;
+  pid_t pid;
+};
+
+pid_t parentOf(pid_t pid) {
+  std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+  std::string stat((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  // "pid (comm) state ppid", comm may contain spaces.
+  size_t end = stat.rfind(')');
+  if (end == std::string::npos) return 0;
+  return std::atoi(stat.c_str() + end + 4);
+}
+
+void add(std::vector<int64_t>& samples, int64_t value) {
+  if (samples.size() == maxSamples) samples.erase(samples.begin());
+  samples.push_back(value);
+}
+
+void onWindowPid(pid_t pid, int64_t time) {
+  for (pid_t current = pid; current > 1; current = parentOf(current)) {
+    auto it = pending.find(current);
+    if (it == pending.end()) continue;
+    add(stats[it->second.app].latencies, time - it->second.launchTime);
+    pending.erase(it);
+    return;
+  }
+}
+
+void onEvent(const std::string& event, const std::string& data);
+
+/*
+  Drops launches which won't map window: timed out, or process exited, e.g. handed off to running instance.
+  Window of descendant whose parent exited can't be matched either. Listener is removed once none left.
+*/
+void evict(int64_t time) {
+  std::erase_if(pending, [time](const auto& it) {
+    return time - it.second.launchTime > timeout ||
+           (kill(it.first, 0) == -1 && errno == ESRCH);
+  });
+  while (pending.size() > maxPending) {
+    auto oldest = std::min_element(
+        pending.begin(), pending.end(), [](const auto& a, const auto& b) {
+          return a.second.launchTime < b.second.launchTime;
+        });
+    pending.erase(oldest);
+  }
+  if (pending.empty() && listener) {
+    Hyprland::removeEventListener(listener);
+    listener = 0;
+  }
+}
+
+void onEvent(const std::string& event, const std::string& data) {
+  if (event != "openwindow") return;
+  int64_t time = g_get_monotonic_time();
+  evict(time);
+  if (pending.empty()) return;
+
+  // Event lacks pid, so look up window. Socket round trip off main thread.
+  std::string address = "0x" + data.substr(0, data.find(','));
+  submit([address]() -> pid_t {
+    std::string error;
+    std::string response = Hyprland::request("j/clients", error);
+    std::vector<HyprlandClient> clients;
+    if (!error.empty() ||
+        glz::read<glz::opts{.error_on_unknown_keys = false}>(clients,
+                                                              response))
+      return 0;
+    for (const auto& client : clients)
+      if (client.address == address) return client.pid;
+    return 0;
+  }).thenOnMain([time](pid_t pid) {
+    if (pid > 0) onWindowPid(pid, time);
+  });
+}
+
+void begin(const std::string& app, pid_t pid, int64_t launchTime) {
+  stats[app].count++;
+  if (pid <= 0) return;
+  pending[pid] = {app, launchTime};
+  evict(launchTime);
+  if (!listener) listener = Hyprland::addEventListener(onEvent);
+}
+
+void hidden(const std::string& app, int64_t hideTime) {
+  add(stats[app].hideTimes, hideTime);
+}
+
+std::string ms(int64_t microseconds) {
+  return std::to_string((microseconds + 500) / 1000) + "ms";
+}
+
+int64_t percentile(std::vector<int64_t> samples, double ratio) {
+  std::sort(samples.begin(), samples.end());
+  return samples[std::min(samples.size() - 1,
+                          (size_t)(ratio * samples.size()))];
+}
+
+std::map<std::string, std::string> query() {
+  std::map<std::string, std::string> result;
+  for (const auto& [app, it] : stats) {
+    std::string value = "count " + std::to_string(it.count);
+    if (!it.latencies.empty()) {
+      value += ", p50 " + ms(percentile(it.latencies, 0.5)) + ", p95 " +
+               ms(percentile(it.latencies, 0.95)) + ", max " +
+               ms(*std::max_element(it.latencies.begin(), it.latencies.end()));
+    } else
+      value += ", no window seen";
+    if (!it.hideTimes.empty())
+      value += ", hide " + ms(percentile(it.hideTimes, 0.5));
+    result[app] = value;
+  }
+  return result;
+}
+}
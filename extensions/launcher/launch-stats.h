@@ -0,0 +1,25 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/*
+  Time from launch (click or Enter) until app maps first window, from Hyprland "openwindow".
+  Window is matched by its pid being spawned process or descendant. Apps reusing already running instance
+  never match and are dropped after timeout.
+*/
+namespace LaunchStats {
+// "launchTime" from g_get_monotonic_time().
+void begin(const std::string& app, pid_t pid, int64_t launchTime);
+// "hideTime" microseconds from launch until launcher window's unmap-event.
+void hidden(const std::string& app, int64_t hideTime);
+// "stats launch" command. Per app e.g. "count 4, p50 310ms, max 920ms, hide 6ms".
+std::map<std::string, std::string> query();
+}
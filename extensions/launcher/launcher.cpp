@@ -7,8 +7,25 @@
 #include <algorithm>
 #include <filesystem>
 
+#include "../../src/daemon.h"
+#include "../../src/metrics.h"
+#include "../../src/probes.h"
+#include "../../src/process.h"
+#include "../../src/scheduler.h"
 #include "../../src/theme.h"
+#include "../../src/trace.h"
 #include "../../src/utils.h"
+#include "glaze/beve.hpp"
+#include "launch-stats.h"
+
+template <>
+struct glz::meta<App> {
+  using T = App;
+  static constexpr auto value =
+      object("file", &T::file, "label", &T::label, "exec", &T::exec, "icon",
+             &T::icon, "themedIcon", &T::themedIcon, "color", &T::color,
+             "actions", &T::actions);
+};
 
 const std::string APPLICATIONS = "/usr/share/applications";
 const std::string USER_APPLICATIONS = HOME + "/.local/share/applications";
@@ -63,6 +80,7 @@ std::string stripFieldCodes(std::string&& exec) {
 }
 
 void loadApps(std::vector<App>& apps, const std::string& directory) {
+  TRACE_SCOPE("loadApps " + directory);
   for (const auto& it : std::filesystem::directory_iterator(directory)) {
     bool isDesktopEntry =
         it.is_regular_file() && it.path().extension() == ".desktop";
@@ -106,9 +124,22 @@ void loadApps(std::vector<App>& apps, const std::string& directory) {
   }
 }
 
-void Launcher::launch(const std::string& command) {
-  deactivate();
-  runNewProcess(command);
+void Launcher::launch(const std::string& command, const std::string& app) {
+  static Metrics::Counter& launches = Metrics::counter("launches_total");
+  launches.add();
+  int64_t launchTime = g_get_monotonic_time();
+  // Hidden counts from compositor unmapping window, so it's kept until unmap-event.
+  window->onUnmap([this, app, launchTime]() {
+    LaunchStats::hidden(app, g_get_monotonic_time() - launchTime);
+    // Not destroyed inside its own event handler.
+    Scheduler::cancel(hideJob);
+    hideJob = Scheduler::after(0, [this]() { deactivate(); });
+  });
+  window->visible(false);
+  // Missing unmap-event mustn't leave launcher active.
+  hideJob = Scheduler::after(500, [this]() { deactivate(); });
+  pid_t pid = Process::spawn(command);
+  LaunchStats::begin(app, pid, launchTime);
 }
 
 void Launcher::openContextMenu(App& app, GdkEventButton* event) {
@@ -133,7 +164,8 @@ void Launcher::openContextMenu(App& app, GdkEventButton* event) {
     auto item = std::make_unique<MenuItem>("Open folder", "folder_open");
     item->onClick([&app, this]() {
       launch("xdg-open " +
-             std::filesystem::path(app.file).parent_path().string());
+                 std::filesystem::path(app.file).parent_path().string(),
+             "xdg-open");
     });
     menu->add(std::move(item));
   }
@@ -142,7 +174,10 @@ void Launcher::openContextMenu(App& app, GdkEventButton* event) {
     for (const auto& action : app.actions) {
       auto item = std::make_unique<MenuItem>(action.second.label);
       item->addClass("no-icon");
-      item->onClick([&action, this]() { launch(action.second.exec); });
+      item->onClick([&app, &action, this]() {
+        launch(action.second.exec,
+               app.label + " (" + action.second.label + ")");
+      });
       menu->add(std::move(item));
     }
   }
@@ -157,6 +192,7 @@ bool searchQuery(std::string text, std::string query) {
 }
 
 void Launcher::update(bool sort) {
+  PROBE2(launcher__update__begin, apps.size(), sort);
   if (sort) {
     auto& pinned = appData.get().pinnedApps;
     std::sort(apps.begin(), apps.end(),
@@ -216,6 +252,9 @@ void Launcher::update(bool sort) {
   pinGrid->visible(!pinGrid->childrens.empty());
   searchPlaceholder->visible(pinGrid->childrens.empty() &&
                              grid->childrens.empty());
+  // Shown apps.
+  PROBE1(launcher__update__end,
+         pinGrid->childrens.size() + grid->childrens.size());
 }
 
 std::unique_ptr<FlowBox> Launcher::createGrid() {
@@ -224,7 +263,7 @@ std::unique_ptr<FlowBox> Launcher::createGrid() {
   grid->onChildClick([this](GtkFlowBoxChild* child) {
     for (auto& app : apps) {
       if (child == (GtkFlowBoxChild*)app.element->widget) {
-        launch(app.exec);
+        launch(app.exec, app.label);
         break;
       }
     }
@@ -322,6 +361,20 @@ void Launcher::updateIcons() {
     app.themedIcon = file;
     app.color = theme["primary_40"];
   }
+  measure();
+}
+
+void Launcher::measure() {
+  size_t bytes = apps.capacity() * sizeof(App);
+  for (const auto& app : apps) {
+    bytes += app.file.capacity() + app.label.capacity() +
+             app.exec.capacity() + app.icon.capacity() +
+             app.themedIcon.native().capacity() + app.color.capacity();
+    for (const auto& [name, action] : app.actions)
+      bytes += name.capacity() + action.label.capacity() +
+               action.exec.capacity() + sizeof(action);
+  }
+  catalogMemory.set(apps.size(), bytes);
 }
 
 void Launcher::onThemeChange() {
@@ -329,17 +382,54 @@ void Launcher::onThemeChange() {
   if (window) update();
 }
 
+void Launcher::onAppDataChange() {
+  Pinned::intialize(apps);
+  if (window) update();
+}
+
 void Launcher::onDeactivate() {
+  if (hideJob) Scheduler::cancel(hideJob);
+  hideJob = 0;
   menu.reset();
   window.reset();
 }
 
+std::vector<App> preloadedApps;
+
+void Launcher::preload() {
+  // Entries come from handoff instead.
+  if (Daemon::reloaded()) return;
+  loadApps(preloadedApps, APPLICATIONS);
+  loadApps(preloadedApps, USER_APPLICATIONS);
+}
+
 Launcher::Launcher() {
   keepAlive = true;
-  loadApps(apps, APPLICATIONS);
-  loadApps(apps, USER_APPLICATIONS);
-  updateIcons();
+  // Entries and themed icons from previous daemon, skips parsing and icon generation.
+  std::string state = Daemon::restore("launcher");
+  if (state.empty() || glz::read_beve(apps, state)) {
+    if (preloadedApps.empty()) {
+      apps.clear();
+      loadApps(apps, APPLICATIONS);
+      loadApps(apps, USER_APPLICATIONS);
+    } else
+      apps = std::move(preloadedApps);
+    updateIcons();
+  } else {
+    // Themed icons reused from previous daemon.
+    static Metrics::Counter& hits = Metrics::counter("icon_cache_hits_total");
+    hits.add(apps.size());
+    measure();
+  }
+  preloadedApps.clear();
+  preloadedApps.shrink_to_fit();
   Pinned::intialize(apps);
 }
 
+std::string Launcher::onHandoff() {
+  std::string buffer;
+  glz::write_beve(apps, buffer);
+  return buffer;
+}
+
 Launcher::~Launcher() { apps.clear(); }
\ No newline at end of file
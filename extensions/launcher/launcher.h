@@ -6,6 +6,7 @@
 
 #include "../../src/element.h"
 #include "../../src/extension.h"
+#include "../../src/memory.h"
 
 struct App {
   std::string file;
@@ -15,7 +16,7 @@ struct App {
   std::filesystem::path themedIcon;
   // todo: add colored or monochrome option.
   std::string color;
-  FlowBoxChild* element;
+  FlowBoxChild* element = nullptr;
 
   struct Action {
     std::string label;
@@ -28,21 +29,31 @@ class Launcher : public Extension {
   std::unique_ptr<Window> window;
   std::unique_ptr<Menu> menu;
   std::vector<App> apps;
+  Memory::Account<Memory::Tag::Launcher> catalogMemory;
   Input* search;
   Box* searchPlaceholder;
   FlowBox* pinGrid;
   FlowBox* grid;
-  void launch(const std::string& command);
+  // Deactivates once window is unmapped after launch.
+  uint hideJob = 0;
+  // "app" names launch in LaunchStats.
+  void launch(const std::string& command, const std::string& app);
   void openContextMenu(App& app, GdkEventButton* event);
   void update(bool sort = true);
   void updateIcons();
+  // Catalog size for "stats memory".
+  void measure();
   std::unique_ptr<FlowBox> createGrid();
   std::unique_ptr<Box> createSearch();
 
  public:
   Launcher();
   ~Launcher();
+  // Parses desktop entries ahead of first run. Safe off main thread.
+  static void preload();
   void onActivate();
   void onDeactivate();
   void onThemeChange();
+  void onAppDataChange();
+  std::string onHandoff();
 };
\ No newline at end of file
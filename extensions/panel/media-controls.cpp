@@ -8,7 +8,8 @@
 
 Player::Player(std::unique_ptr<PlayerController> &&_controller)
     : controller(std::move(_controller)) {
-  onDragEnd = std::make_unique<Debouncer>(400, [this]() { dragging = false; });
+  onDragEnd = std::make_unique<Debouncer>(
+      400, [this]() { dragging = false; }, Debouncer::Debounce);
 }
 
 Player::~Player() {
@@ -24,22 +25,27 @@ void Player::updateSlider() {
   if (!dragging) slider->value(controller->progress());
 }
 
-void Player::updateTheme() {
+struct ArtTheme {
   AppData::Theme theme;
+  bool invalidArt;
   bool thumbnailBackgroundDark = true;
+};
+
+// Decoding and quantization are slow for large art, so runs on worker. No global state here.
+ArtTheme createArtTheme(const std::string &artUrl, bool lightMode) {
+  ArtTheme result;
+  AppData::Theme &theme = result.theme;
+  bool &thumbnailBackgroundDark = result.thumbnailBackgroundDark;
 
-  cairo_surface_t *surface =
-      cairo_image_surface_create_from_png(controller->artUrl.c_str());
+  cairo_surface_t *surface = cairo_image_surface_create_from_png(artUrl.c_str());
   int width = cairo_image_surface_get_width(surface);
   int height = cairo_image_surface_get_height(surface);
   bool fileNotFound = width == 0;
   bool chromiumSplashArt = width == 256 && width == height;
-  bool invalidArt = fileNotFound || chromiumSplashArt;
-  if (invalidArt)
-    theme = appData.get().theme;
-  else {
+  result.invalidArt = fileNotFound || chromiumSplashArt;
+  if (!result.invalidArt) {
     cairo_surface_t *thumbnailSurface = Theme::resize(surface, width, height);
-    theme = Theme::fromImage(thumbnailSurface);
+    theme = Theme::fromImage(thumbnailSurface, lightMode);
 
     int centerX = cairo_image_surface_get_width(thumbnailSurface) / 2;
     int centerY = cairo_image_surface_get_height(thumbnailSurface) / 2;
@@ -55,7 +61,25 @@ void Player::updateTheme() {
     cairo_surface_destroy(thumbnailSurface);
   }
   cairo_surface_destroy(surface);
+  return result;
+}
+
+void Player::updateTheme() {
+  uint request = ++themeRequest;
+  std::weak_ptr<bool> alive = this->alive;
+  // App data is main thread only, job gets copies.
+  submit([artUrl = controller->artUrl, lightMode = appData.get().lightMode]() {
+    return createArtTheme(artUrl, lightMode);
+  }).thenOnMain([this, alive, request](ArtTheme result) {
+    // Player removed or art changed meanwhile.
+    if (alive.expired() || request != themeRequest) return;
+    if (result.invalidArt) result.theme = appData.get().theme;
+    applyTheme(result.theme, result.invalidArt, result.thumbnailBackgroundDark);
+  });
+}
 
+void Player::applyTheme(AppData::Theme &theme, bool invalidArt,
+                        bool thumbnailBackgroundDark) {
   if (!cssProvider) {
     cssProvider = gtk_css_provider_new();
     gtk_style_context_add_provider_for_screen(
@@ -87,6 +111,7 @@ void Player::updateTheme() {
          "; } ";
 
   gtk_css_provider_load_from_data(cssProvider, css.c_str(), -1, nullptr);
+  cssMemory.set(1, css.size());
 }
 
 void Player::update() {
@@ -191,7 +216,7 @@ void MediaControls::update() {
 
 void MediaControls::activate() {
   controller = std::make_unique<MediaController>();
-  controller->onPlayersChange([this]() { update(); });
+  controller->onPlayersChange([this](const std::string&, bool) { update(); });
   update();
 }
 
@@ -18,6 +18,7 @@ class Player {
 
   std::string className;
   GtkCssProvider *cssProvider = nullptr;
+  Memory::Account<Memory::Tag::Css> cssMemory;
 
   PlayerController::Status lastStatus;
   std::string lastTitle;
@@ -26,7 +27,13 @@ class Player {
   bool dragging = false;
   std::unique_ptr<Debouncer> onDragEnd;
 
+  // Guards worker callbacks against destroyed player.
+  std::shared_ptr<bool> alive = std::make_shared<bool>();
+  uint themeRequest = 0;
+
   void updateTheme();
+  void applyTheme(AppData::Theme &theme, bool invalidArt,
+                  bool thumbnailBackgroundDark);
   void update();
 
  public:
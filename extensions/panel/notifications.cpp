@@ -5,6 +5,7 @@
 #include "notifications.h"
 
 #include "../../src/components/notifications.h"
+#include "glaze/beve.hpp"
 
 namespace Notifications {
 Box* container;
@@ -15,6 +16,18 @@ std::unique_ptr<Box> create() {
   container = box.get();
   return box;
 }
-void initialize() { manager = std::make_unique<NotificationManager>(); }
+void initialize(const std::string& state) {
+  manager = std::make_unique<NotificationManager>();
+  if (!state.empty() && glz::read_beve(manager->list, state))
+    manager->list.clear();
+  manager->measure();
+}
+
+std::string save() {
+  std::string buffer;
+  if (manager) glz::write_beve(manager->list, buffer);
+  return buffer;
+}
+
 void destroy() { manager.reset(); }
 }
\ No newline at end of file
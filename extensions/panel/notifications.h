@@ -8,6 +8,8 @@
 
 namespace Notifications {
 std::unique_ptr<Box> create();
-void initialize();
+// "state" from save() of previous daemon, see Daemon::restore().
+void initialize(const std::string& state = "");
+std::string save();
 void destroy();
 }
\ No newline at end of file
@@ -14,7 +14,10 @@
 #include "../../src/components/bluetooth.h"
 #include "../../src/components/hyprland.h"
 #include "../../src/components/network.h"
+#include "../../src/daemon.h"
 #include "../../src/element.h"
+#include "../../src/scheduler.h"
+#include "../../src/state.h"
 #include "../../src/utils.h"
 #include "notifications.h"
 
@@ -308,6 +311,10 @@ std::tuple<float, float> getUsage() {
 
 void update() {
   auto [totalGb, usedGb] = getUsage();
+  State::usage.ramUsedGb = usedGb;
+  State::usage.ramTotalGb = totalGb;
+  State::usage.ramTime = g_get_monotonic_time();
+  State::publish();
   std::ostringstream oss;
   oss << std::fixed << std::setprecision(1) << totalGb;
   std::string totalRam = oss.str() + " GB";
@@ -385,7 +392,10 @@ std::vector<Sensor> getTemperatureSensors() {
 void onClick() { runNewProcess("foot --title=system-monitor btm"); }
 
 void update() {
-  tile->label->set(std::to_string(getUsage()) + "% use");
+  State::usage.cpu = getUsage();
+  State::usage.cpuTime = g_get_monotonic_time();
+  State::publish();
+  tile->label->set(std::to_string(State::usage.cpu) + "% use");
 
   auto sensors = getTemperatureSensors();
   tile->description->set(std::to_string(sensors[0].temperature) + "°C (" +
@@ -462,8 +472,9 @@ std::unique_ptr<Button> create() {
   auto _button =
       std::make_unique<Button>(Button::Type::Text, Button::None, Button::Small);
   button = _button.get();
-  button->onClick(
-      []() { run("xdg-open https://calendar.google.com/calendar"); });
+  button->onClick([]() {
+    runNewProcess("xdg-open https://calendar.google.com/calendar");
+  });
   return _button;
 }
 }
@@ -471,6 +482,8 @@ std::unique_ptr<Button> create() {
 void Panel::update() {
   CpuTile::update();
   RamTile::update();
+  Uptime::update();
+  TimeDate::update();
 
   for (auto &player : mediaControls->players) player->updateSlider();
 }
@@ -483,22 +496,14 @@ void Panel::beforeExpandStart() {
   NetworkTile::listen();
   BluetoothTile::listen();
   NightLightTile::update();
-  Uptime::update();
-  TimeDate::update();
   update();
-  updateTimer = g_timeout_add(
-      1000,
-      [](gpointer data) -> gboolean {
-        auto _this = static_cast<Panel *>(data);
-        _this->update();
-        return G_SOURCE_CONTINUE;
-      },
-      this);
+  // On second boundary, so clock changes with system clock.
+  updateTimer = Scheduler::every(1000, [this]() { update(); }, 50, true);
 }
 
 void Panel::beforeCollapseStart() {
   if (updateTimer > 0) {
-    g_source_remove(updateTimer);
+    Scheduler::cancel(updateTimer);
     updateTimer = 0;
   };
   mediaControls->deactivate();
@@ -564,13 +569,13 @@ Panel::Panel() {
     auto power = std::make_unique<Button>(Button::Type::Icon, Button::None,
                                           Button::Small);
     power->setContent("power_settings_new");
-    power->onClick([]() { run("poweroff"); });
+    power->onClick([]() { runNewProcess("poweroff"); });
     footer->add(std::move(power));
 
     auto reboot = std::make_unique<Button>(Button::Type::Icon, Button::None,
                                            Button::Small);
     reboot->setContent("restart_alt");
-    reboot->onClick([]() { run("reboot"); });
+    reboot->onClick([]() { runNewProcess("reboot"); });
     footer->add(std::move(reboot));
 
     footer->add(Uptime::create());
@@ -600,9 +605,11 @@ Panel::Panel() {
   transition = std::make_unique<Transition>(body);
   transition->duration = 200;
 
-  Notifications::initialize();
+  Notifications::initialize(Daemon::restore("panel"));
 }
 
+std::string Panel::onHandoff() { return Notifications::save(); }
+
 Panel::~Panel() {
   // Audio::initialize();
   // Audio::onChange([]() {
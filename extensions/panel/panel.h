@@ -15,7 +15,7 @@ class Panel : public Extension {
   Transition::Frame collapsed = {24, 24};
   Transition::Frame expanded = {340, -1};
   Box* body;
-  int updateTimer = 0;
+  uint updateTimer = 0;
 
   void beforeExpandStart();
   void beforeCollapseStart();
@@ -30,6 +30,7 @@ class Panel : public Extension {
 
   Panel();
   ~Panel();
+  std::string onHandoff();
 };
 
 // todo: expose tiles here. so user can use on custom extensions.
\ No newline at end of file
@@ -0,0 +1,146 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <latch>
+#include <sstream>
+#include <thread>
+
+#include "../ipc.h"
+#include "../utils.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  uint16_t clients = 8;
+  uint32_t requests = 1000;
+  // Each client cycles through these commands.
+  std::vector<std::vector<std::string>> mix = {{"ping"}};
+};
+
+std::vector<std::vector<std::string>> parseMix(const std::string& value) {
+  std::vector<std::vector<std::string>> mix;
+  std::stringstream commands(value);
+  std::string command;
+  while (std::getline(commands, command, ',')) {
+    std::vector<std::string> args;
+    std::stringstream ss(command);
+    std::string arg;
+    while (ss >> arg) args.push_back(arg);
+    if (!args.empty()) mix.emplace_back(args);
+  }
+  return mix;
+}
+
+bool parseOptions(const std::vector<std::string>& args, Options& options,
+                  std::string& error) {
+  for (size_t index = 2; index < args.size(); index++) {
+    const std::string& key = args[index];
+    if (index + 1 >= args.size()) {
+      error = "Missing value for " + key + ".";
+      return false;
+    }
+    const std::string& value = args[++index];
+    try {
+      if (key == "--clients")
+        options.clients = std::max(1, std::stoi(value));
+      else if (key == "--requests")
+        options.requests = std::max(1, std::stoi(value));
+      else if (key == "--mix")
+        options.mix = parseMix(value);
+      else {
+        error = "Unknown option " + key + ".";
+        return false;
+      }
+    } catch (const std::exception&) {
+      error = "Invalid value '" + value + "' for " + key + ".";
+      return false;
+    }
+  }
+  if (options.mix.empty()) {
+    error = "Empty --mix.";
+    return false;
+  }
+  return true;
+}
+
+double percentile(const std::vector<double>& sorted, double value) {
+  size_t index = std::ceil(value * sorted.size());
+  return sorted[std::clamp<size_t>(index, 1, sorted.size()) - 1];
+}
+
+void bench(const std::vector<std::string>& args, std::string& error) {
+  if (args.size() < 2 || args[1] != "ipc") {
+    error = "Unknown benchmark. Available: ipc";
+    return;
+  }
+  Options options;
+  if (!parseOptions(args, options, error)) return;
+
+  // Latencies in microseconds, one list per client so threads don't share.
+  std::vector<std::vector<double>> latencies(options.clients);
+  std::atomic<uint32_t> failed = 0;
+  std::atomic<uint16_t> unconnected = 0;
+  std::latch ready(options.clients + 1);
+
+  std::vector<std::thread> threads;
+  for (uint16_t id = 0; id < options.clients; id++) {
+    threads.emplace_back([&, id]() {
+      Ipc::Client client;
+      std::string connectError;
+      // Connect before start, so setup isn't measured.
+      if (!client.connect(connectError)) unconnected++;
+      ready.arrive_and_wait();
+      if (!client.connected()) return;
+
+      auto& samples = latencies[id];
+      samples.reserve(options.requests);
+      for (uint32_t index = 0; index < options.requests; index++) {
+        const auto& command = options.mix[index % options.mix.size()];
+        auto start = Clock::now();
+        Ipc::Response response = client.request(command);
+        std::chrono::duration<double, std::micro> elapsed =
+            Clock::now() - start;
+        samples.push_back(elapsed.count());
+        if (!response.error.empty()) failed++;
+        if (!client.connected()) break;
+      }
+    });
+  }
+  ready.arrive_and_wait();
+  auto start = Clock::now();
+  for (auto& thread : threads) thread.join();
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+
+  if (unconnected == options.clients) {
+    error = "Unable to connect daemon. Is it running?";
+    return;
+  }
+
+  std::vector<double> all;
+  for (const auto& samples : latencies)
+    all.insert(all.end(), samples.begin(), samples.end());
+  if (all.empty()) {
+    error = "No requests completed.";
+    return;
+  }
+  std::sort(all.begin(), all.end());
+
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(1);
+  oss << options.clients - unconnected << " clients, " << all.size()
+      << " requests, " << failed << " failed\n";
+  oss << "p50 " << percentile(all, 0.50) << "us  p95 "
+      << percentile(all, 0.95) << "us  p99 " << percentile(all, 0.99)
+      << "us  max " << all.back() << "us\n";
+  oss << std::setprecision(0) << all.size() / elapsed.count() << " req/s";
+  Log::info(oss.str());
+}
@@ -0,0 +1,11 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// "bench ipc" load generator against running daemon.
+void bench(const std::vector<std::string>& args, std::string& error);
@@ -0,0 +1,83 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+/*
+  Minimal CLI for keybindings and scripts, without GTK, PipeWire linkage.
+  Speaks daemon protocol and runs "patch". Rest is handed to full "system-ui" binary.
+*/
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <iostream>
+
+#include "actions/patch.h"
+#include "ipc.h"
+#include "utils.h"
+
+// Full binary next to this one, otherwise from PATH.
+[[noreturn]] void delegate(char* argv[]) {
+  std::error_code error;
+  auto self = std::filesystem::read_symlink("/proc/self/exe", error);
+  auto full = self.parent_path() / "system-ui";
+  argv[0] = const_cast<char*>("system-ui");
+  if (!error && std::filesystem::exists(full)) execv(full.c_str(), argv);
+  execvp("system-ui", argv);
+  Log::error("Unable to run system-ui.");
+  exit(127);
+}
+
+int main(int argc, char* argv[]) {
+  if (argc <= 1 || std::string(argv[1]) == "--help") delegate(argv);
+
+  Ipc::Client client;
+  std::vector<std::string> args(argv + 1, argv + argc);
+  if (args[0] == "--json") {
+    client.format = Ipc::Format::Json;
+    args.erase(args.begin());
+  }
+  if (args.empty()) delegate(argv);
+  std::string command = args[0] + (args.size() > 1 ? " " + args[1] : "");
+
+  if (args[0] == "patch") {
+    if (args.size() != 3) {
+      Log::error("Invalid amount of arguments.");
+      return 1;
+    }
+    std::string error;
+    patch(args[1], args[2], error);
+    if (error.empty()) return 0;
+    Log::error(error);
+    return 1;
+  }
+
+  if (command == "run daemon" || args[0] == "watch" || args[0] == "bench" ||
+      args[0] == "-")
+    delegate(argv);
+
+  Ipc::Response response = client.request(args);
+  if (!client.connected()) {
+    // Works without daemon in full binary.
+    if (args[0] == "media") delegate(argv);
+    if (command == "exit daemon" || command == "reload daemon")
+      response.error = "Daemon hasn't been started.";
+    Log::error(response.error);
+    return 1;
+  }
+
+  if (client.format == Ipc::Format::Json) {
+    std::cout << client.buffer << std::endl;
+    return response.code;
+  }
+  if (!response.error.empty()) {
+    Log::error(response.error);
+    return response.code;
+  }
+  if (!response.info.empty()) Log::info(response.info);
+  if (!response.data.empty()) {
+    glz::write_json(response.data, client.buffer);
+    std::cout << client.buffer << std::endl;
+  }
+  return 0;
+}
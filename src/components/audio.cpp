@@ -9,8 +9,11 @@
 #include <spa/pod/builder.h>
 #include <spa/pod/iter.h>
 
+#include <atomic>
 #include <cmath>
 
+#include "../metrics.h"
+#include "../probes.h"
 #include "glaze/json.hpp"
 #include "pipewire/thread-loop.h"
 
@@ -31,10 +34,21 @@ namespace Audio {
 Node *defaultSink;
 std::vector<std::unique_ptr<Node>> nodes;
 std::vector<std::unique_ptr<Device>> devices;
-std::unique_ptr<Debouncer> changeCallback;
+std::vector<std::function<void()>> changeCallbacks;
+// Listeners debounce themselves, e.g. State per topic, so only one main thread hop per burst.
+std::atomic<bool> changePending = false;
 
 void onChange(const std::function<void()> &callback) {
-  changeCallback = std::make_unique<Debouncer>(100, callback);
+  changeCallbacks.emplace_back(callback);
+}
+
+// PipeWire thread.
+void changed() {
+  if (changePending.exchange(true)) return;
+  runOnMain([]() {
+    changePending = false;
+    for (const auto &callback : changeCallbacks) callback();
+  });
 }
 
 Device *getDeviceById(uint32_t id) {
@@ -101,7 +115,7 @@ int onMetadataProperty(void *data, uint32_t subject, const char *key,
     for (const auto &node : nodes) {
       if (node->name == sinkValue.name) {
         defaultSink = node.get();
-        changeCallback->call();
+        changed();
         break;
       }
     }
@@ -125,6 +139,11 @@ void onNodeInfo(void *data, const struct pw_node_info *info) {
 void onNodeParam(void *data, int seq, uint32_t id, uint32_t index,
                  uint32_t next, const struct spa_pod *param) {
   Node *node = (Node *)data;
+  // PipeWire thread.
+  PROBE2(pipewire__node__param, node->id, id);
+  static Metrics::Counter& events =
+      Metrics::counter("pipewire_param_events_total");
+  events.add();
   spa_pod_object *object = (spa_pod_object *)param;
   spa_pod_prop *prop;
   SPA_POD_OBJECT_FOREACH(object, prop) {
@@ -132,7 +151,11 @@ void onNodeParam(void *data, int seq, uint32_t id, uint32_t index,
       float *volumes =
           (float *)spa_pod_get_array(&prop->value, &node->channels);
       node->volume = std::round(cubicFromLinearVolume(volumes[0]) * 100);
-      changeCallback->call();
+      changed();
+    }
+    if (prop->key == SPA_PROP_mute) {
+      spa_pod_get_bool(&prop->value, &node->muted);
+      changed();
     }
   }
 }
@@ -280,5 +303,6 @@ void destroy() {
   pw_deinit();
 
   nodes.clear();
+  changeCallbacks.clear();
 }
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <memory>
 #include <vector>
 
+#include "../memory.h"
 #include "../utils.h"
 
 namespace Audio {
@@ -20,9 +21,11 @@ struct Node {
   std::string label;
   uint32_t deviceId;
   uint16_t volume = 0;
+  bool muted = false;
   uint32_t channels = 0;
   pw_proxy *proxy;
   spa_hook listener;
+  Memory::Account<Memory::Tag::PipeWire> memory{1, sizeof(Node)};
 };
 struct Route {
   int index;
@@ -34,11 +37,13 @@ struct Device {
   Route ouput;
   pw_proxy *proxy;
   spa_hook listener;
+  Memory::Account<Memory::Tag::PipeWire> memory{1, sizeof(Device)};
 };
 extern std::vector<std::unique_ptr<Node>> nodes;
 extern std::vector<std::unique_ptr<Device>> devices;
 extern Node *defaultSink;
 
+// Adds listener, called on main thread.
 void onChange(const std::function<void()> &callback);
 void volume(Node *node, uint16_t cubicVolumePercent);
 void initialize();
@@ -6,6 +6,8 @@
 
 #include <string>
 
+#include "../metrics.h"
+#include "../trace.h"
 #include "../utils.h"
 
 BluetoothDevice &findOrCreateDevice(const std::string &path,
@@ -112,6 +114,9 @@ void BluetoothController::onInterfacesAdded(GDBusConnection *connection,
                                             const gchar *signal,
                                             GVariant *parameters,
                                             gpointer data) {
+  static Metrics::Counter& signals =
+      Metrics::counter("dbus_signals_total{component=\"bluetooth\"}");
+  signals.add();
   BluetoothController *_this = static_cast<BluetoothController *>(data);
 
   char *path;
@@ -124,6 +129,9 @@ void BluetoothController::onInterfacesAdded(GDBusConnection *connection,
 void BluetoothController::onInterfacesRemoved(
     GDBusConnection *connection, const gchar *sender, const gchar *,
     const gchar *, const gchar *signal, GVariant *parameters, gpointer data) {
+  static Metrics::Counter& signals =
+      Metrics::counter("dbus_signals_total{component=\"bluetooth\"}");
+  signals.add();
   bool changed = false;
   BluetoothController *_this = static_cast<BluetoothController *>(data);
 
@@ -151,6 +159,9 @@ void BluetoothController::onInterfacesRemoved(
 void BluetoothController::onInterfaceChange(
     GDBusConnection *connection, const gchar *sender, const gchar *path,
     const gchar *, const gchar *signal, GVariant *parameters, gpointer data) {
+  static Metrics::Counter& signals =
+      Metrics::counter("dbus_signals_total{component=\"bluetooth\"}");
+  signals.add();
   BluetoothController *_this = static_cast<BluetoothController *>(data);
   char *interface;
   GVariantIter *properties;
@@ -160,10 +171,12 @@ void BluetoothController::onInterfaceChange(
 }
 
 void BluetoothController::loadDevices() {
+  TRACE_SCOPE("dbus bluez GetManagedObjects");
   GVariant *result = g_dbus_connection_call_sync(
       connection, "org.bluez", "/", "org.freedesktop.DBus.ObjectManager",
       "GetManagedObjects", nullptr, nullptr, G_DBUS_CALL_FLAGS_NONE, -1,
       nullptr, nullptr);
+  if (!result) return;  // bluez not running.
   GVariantIter *objects;
   g_variant_get(result, "(a{oa{sa{sv}}})", &objects);
   g_variant_unref(result);
@@ -207,6 +220,7 @@ BluetoothController::~BluetoothController() {
 }
 
 void BluetoothController::enable(bool value) {
+  TRACE_SCOPE("dbus bluez Powered");
   GError *error = nullptr;
   GVariant *result = nullptr;
   result = g_dbus_connection_call_sync(
@@ -4,36 +4,47 @@
 
 #include "hyprland.h"
 
+#include <glib.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
 
 #include <filesystem>
+#include <map>
+
+#include "../scheduler.h"
+#include "../utils.h"
 
 namespace Hyprland {
-std::string request(std::string command, std::string& error) {
-  std::string signature = getenv("HYPRLAND_INSTANCE_SIGNATURE");
-  if (signature.empty()) {
+int connectSocket(const std::string& name, std::string& error) {
+  const char* signature = getenv("HYPRLAND_INSTANCE_SIGNATURE");
+  if (!signature || !signature[0]) {
     error = "HYPRLAND_INSTANCE_SIGNATURE env missing.";
-    return "";
+    return -1;
   }
 
-  std::string socketFile = "/tmp/hypr/" + signature + "/.socket.sock";
+  std::string socketFile = "/tmp/hypr/" + std::string(signature) + "/" + name;
   if (!std::filesystem::exists(socketFile)) {
     error = socketFile + " file not found.";
-    return "";
+    return -1;
   }
 
   sockaddr_un address = {0};
   address.sun_family = AF_UNIX;
   strncpy(address.sun_path, socketFile.c_str(), sizeof(address.sun_path) - 1);
 
-  int server = socket(AF_UNIX, SOCK_STREAM, 0);
+  int server = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
   if (connect(server, (sockaddr*)&address, SUN_LEN(&address)) < 0) {
     close(server);
     error = "Unable to connect Hyprland socket.";
-    return "";
+    return -1;
   }
+  return server;
+}
+
+std::string request(std::string command, std::string& error) {
+  int server = connectSocket(".socket.sock", error);
+  if (server == -1) return "";
 
   // prepend another "/" if command contains "/" e.g. file path.
   // that's how hyprland parses https://github.com/hyprwm/Hyprland/blob/main/src/debug/HyprCtl.cpp#L1405
@@ -59,4 +70,94 @@ std::string request(std::string command, std::string& error) {
   close(server);
   return response;
 }
-}
\ No newline at end of file
+
+std::map<uint, EventCallback> listeners;
+uint lastListenerId = 0;
+GIOChannel* events = nullptr;
+uint eventsWatch = 0;
+std::string eventsBuffer;
+// Retries connecting while there are listeners, e.g. Hyprland restarting.
+constexpr uint reconnectDelay = 1000;
+uint reconnectJob = 0;
+
+void disconnectEvents() {
+  if (reconnectJob) Scheduler::cancel(reconnectJob);
+  reconnectJob = 0;
+  if (eventsWatch) g_source_remove(eventsWatch);
+  eventsWatch = 0;
+  if (events) g_io_channel_unref(events);
+  events = nullptr;
+  eventsBuffer.clear();
+}
+
+gboolean onEvents(GIOChannel* channel, GIOCondition condition, gpointer data);
+
+void reconnectLater();
+
+// Retries are quiet, failure is logged once.
+void connectEvents(bool retry = false) {
+  reconnectJob = 0;
+  std::string error;
+  int socket = connectSocket(".socket2.sock", error);
+  if (socket == -1) {
+    if (!retry) Log::error(error);
+    return reconnectLater();
+  }
+  events = g_io_channel_unix_new(socket);
+  g_io_channel_set_close_on_unref(events, true);
+  eventsWatch = g_io_add_watch(events,
+                               (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR),
+                               onEvents, nullptr);
+  g_source_set_name_by_id(eventsWatch, "hyprland events");
+}
+
+void reconnectLater() {
+  reconnectJob = Scheduler::after(
+      reconnectDelay, []() { connectEvents(true); }, reconnectDelay / 10);
+}
+
+gboolean onEvents(GIOChannel* channel, GIOCondition condition, gpointer data) {
+  char buffer[4096];
+  ssize_t size = -1;
+  // HUP may come with last events still readable.
+  if (condition & G_IO_IN)
+    size = read(g_io_channel_unix_get_fd(channel), buffer, sizeof(buffer));
+  if (size <= 0) {
+    Log::warn("Hyprland event socket closed, reconnecting.");
+    // Watch is removed by returning.
+    eventsWatch = 0;
+    disconnectEvents();
+    reconnectLater();
+    return G_SOURCE_REMOVE;
+  }
+  eventsBuffer.append(buffer, size);
+
+  // Lines are "event>>data".
+  size_t end;
+  while ((end = eventsBuffer.find('\n')) != std::string::npos) {
+    std::string line = eventsBuffer.substr(0, end);
+    eventsBuffer.erase(0, end + 1);
+    size_t separator = line.find(">>");
+    if (separator == std::string::npos) continue;
+    std::string event = line.substr(0, separator);
+    std::string value = line.substr(separator + 2);
+    // Copy, listener may remove itself.
+    auto current = listeners;
+    for (const auto& [id, listener] : current) {
+      if (listeners.contains(id)) listener(event, value);
+    }
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+uint addEventListener(const EventCallback& callback) {
+  if (!events && !reconnectJob) connectEvents();
+  listeners[++lastListenerId] = callback;
+  return lastListenerId;
+}
+
+void removeEventListener(uint id) {
+  listeners.erase(id);
+  if (listeners.empty()) disconnectEvents();
+}
+}
@@ -4,8 +4,16 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 
 namespace Hyprland {
 std::string request(std::string command, std::string& error);
+
+// "openwindow", "address,workspace,class,title" from event socket.
+using EventCallback =
+    std::function<void(const std::string& event, const std::string& data)>;
+// Event socket is connected while there are listeners.
+uint addEventListener(const EventCallback& callback);
+void removeEventListener(uint id);
 }
\ No newline at end of file
@@ -4,8 +4,13 @@
 
 #include "media.h"
 
+#include <algorithm>
 #include <cmath>
 
+#include "../metrics.h"
+#include "../probes.h"
+#include "../trace.h"
+
 #define DBUS_INTERFACE "org.freedesktop.DBus"
 #define PROPERTIES_INTERFACE "org.freedesktop.DBus.Properties"
 #define DBUS_PATH "/org/freedesktop/DBus"
@@ -64,6 +69,7 @@ void parseProperties(GVariant* properties, PlayerController* player) {
 PlayerController::PlayerController(GDBusConnection* connection,
                                    const std::string& bus)
     : connection(connection), bus(bus) {
+  TRACE_SCOPE("dbus mpris GetAll");
   GVariant* result = g_dbus_connection_call_sync(
       connection, bus.c_str(), MPRIS_PATH, PROPERTIES_INTERFACE, "GetAll",
       g_variant_new("(s)", PLAYER_INTERFACE), G_VARIANT_TYPE("(a{sv})"),
@@ -79,11 +85,14 @@ PlayerController::PlayerController(GDBusConnection* connection,
 }
 
 PlayerController::~PlayerController() {
+  g_cancellable_cancel(cancellable);
+  g_object_unref(cancellable);
   if (propertiesChangeSignal != 0)
     g_dbus_connection_signal_unsubscribe(connection, propertiesChangeSignal);
 }
 
 void PlayerController::call(const std::string& method) {
+  TRACE_SCOPE("dbus mpris " + method);
   GVariant* result = g_dbus_connection_call_sync(
       connection, bus.c_str(), MPRIS_PATH, PLAYER_INTERFACE, method.c_str(),
       nullptr, nullptr, G_DBUS_CALL_FLAGS_NONE, -1, nullptr, nullptr);
@@ -96,7 +105,11 @@ void PlayerController::onChange(const std::function<void()>& callback) {
                     const gchar* object_path, const gchar* interface_name,
                     const gchar* signal_name, GVariant* parameters,
                     gpointer data) {
+    static Metrics::Counter& signals =
+        Metrics::counter("dbus_signals_total{component=\"mpris\"}");
+    signals.add();
     PlayerController* _this = static_cast<PlayerController*>(data);
+    PROBE1(mpris__properties__changed, _this->bus.c_str());
     GVariant* properties = g_variant_get_child_value(parameters, 1);
     parseProperties(properties, _this);
     g_variant_unref(properties);
@@ -114,22 +127,60 @@ void PlayerController::next() { call("Next"); }
 
 void PlayerController::previous() { call("Previous"); }
 
-uint8_t PlayerController::progress() {
+uint64_t PlayerController::position() {
+  TRACE_SCOPE("dbus mpris Position");
   GVariant* result = g_dbus_connection_call_sync(
       connection, bus.c_str(), MPRIS_PATH, PROPERTIES_INTERFACE, "Get",
       g_variant_new("(ss)", PLAYER_INTERFACE, "Position"),
       G_VARIANT_TYPE("(v)"), G_DBUS_CALL_FLAGS_NONE, -1, nullptr, nullptr);
+  if (!result) return 0;
   GVariant* value;
   g_variant_get(result, "(v)", &value);
   uint64_t position = g_variant_get_int64(value);
   g_variant_unref(value);
   g_variant_unref(result);
-  return position > 0 ? std::round((position * 100) / duration) : 0;
+  return position;
+}
+
+void PlayerController::position(
+    const std::function<void(uint64_t)>& callback) {
+  using Callback = std::function<void(uint64_t)>;
+  auto done = [](GObject* source, GAsyncResult* asyncResult, gpointer data) {
+    std::unique_ptr<Callback> callback(static_cast<Callback*>(data));
+    GError* error = nullptr;
+    GVariant* result = g_dbus_connection_call_finish((GDBusConnection*)source,
+                                                     asyncResult, &error);
+    if (!result) {
+      bool cancelled = g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+      g_error_free(error);
+      // Player is gone.
+      if (cancelled) return;
+      return (*callback)(0);
+    }
+    GVariant* value;
+    g_variant_get(result, "(v)", &value);
+    uint64_t position = g_variant_get_int64(value);
+    g_variant_unref(value);
+    g_variant_unref(result);
+    (*callback)(position);
+  };
+  g_dbus_connection_call(
+      connection, bus.c_str(), MPRIS_PATH, PROPERTIES_INTERFACE, "Get",
+      g_variant_new("(ss)", PLAYER_INTERFACE, "Position"),
+      G_VARIANT_TYPE("(v)"), G_DBUS_CALL_FLAGS_NONE, -1, cancellable, done,
+      new Callback(callback));
+}
+
+uint8_t PlayerController::progress() {
+  uint64_t position = this->position();
+  return position > 0 && duration > 0 ? std::round((position * 100) / duration)
+                                      : 0;
 }
 
 void PlayerController::progress(uint8_t percent) {
   // position must be uint64. otherwise browser ignores method call.
   uint64_t position = (percent / 100.0) * duration;
+  TRACE_SCOPE("dbus mpris SetPosition");
   GVariant* result = g_dbus_connection_call_sync(
       connection, bus.c_str(), MPRIS_PATH, PLAYER_INTERFACE, "SetPosition",
       g_variant_new("(ox)", trackId.c_str(), position), nullptr,
@@ -147,7 +198,13 @@ MediaController::~MediaController() {
   g_object_unref(connection);
 }
 
+std::unique_ptr<PlayerController> MediaController::getPlayer(
+    const std::string& bus) {
+  return std::make_unique<PlayerController>(connection, bus);
+}
+
 std::vector<std::unique_ptr<PlayerController>> MediaController::getPlayers() {
+  TRACE_SCOPE("dbus ListNames");
   std::vector<std::unique_ptr<PlayerController>> players;
   GVariant* result = g_dbus_connection_call_sync(
       connection, DBUS_INTERFACE, DBUS_PATH, DBUS_INTERFACE, "ListNames",
@@ -157,30 +214,46 @@ std::vector<std::unique_ptr<PlayerController>> MediaController::getPlayers() {
   g_variant_get(result, "(as)", &iter);
   char* name;
   while (g_variant_iter_next(iter, "&s", &name)) {
-    if (std::string_view(name).starts_with("org.mpris.MediaPlayer2.")) {
-      players.emplace_back(
-          std::make_unique<PlayerController>(connection, std::string(name)));
-    }
+    if (std::string_view(name).starts_with("org.mpris.MediaPlayer2."))
+      players.emplace_back(getPlayer(name));
   }
   g_variant_iter_free(iter);
   g_variant_unref(result);
   return players;
 }
 
-void MediaController::onPlayersChange(const std::function<void()>& callback) {
+void MediaController::onPlayersChange(const PlayersChangeCallback& callback) {
   playersChangeCallback = callback;
   auto changed = [](GDBusConnection* connection, const gchar* sender_name,
                     const gchar* object_path, const gchar* interface_name,
                     const gchar* signal_name, GVariant* parameters,
                     gpointer data) {
+    static Metrics::Counter& signals =
+        Metrics::counter("dbus_signals_total{component=\"mpris\"}");
+    signals.add();
     MediaController* _this = static_cast<MediaController*>(data);
     char *name, *to;
     g_variant_get(parameters, "(&s&s&s)", &name, nullptr, &to);
     if (!std::string_view(name).starts_with("org.mpris.MediaPlayer2.")) return;
-    _this->playersChangeCallback();
+    _this->playersChangeCallback(name, to[0] != '\0');
   };
   nameOwnerChangeSignal = g_dbus_connection_signal_subscribe(
       connection, DBUS_INTERFACE, DBUS_INTERFACE, "NameOwnerChanged",
       "/org/freedesktop/DBus", nullptr, G_DBUS_SIGNAL_FLAGS_NONE, changed, this,
       nullptr);
-}
\ No newline at end of file
+}
+
+void mediaAction(PlayerController& player, const std::vector<std::string>& args,
+                 std::string& error) {
+  std::string action = args.size() > 1 ? args[1] : "";
+  if (action == "play-pause")
+    player.playPause();
+  else if (action == "next")
+    player.next();
+  else if (action == "previous")
+    player.previous();
+  else if (action == "progress" && args.size() > 2)
+    player.progress(std::clamp(std::atoi(args[2].c_str()), 0, 100));
+  else
+    error = "Unknown media action '" + action + "'.";
+}
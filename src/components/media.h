@@ -8,12 +8,16 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 class PlayerController {
   GDBusConnection* connection;
   void call(const std::string& method);
   int propertiesChangeSignal = 0;
   std::function<void()> changeCallback;
+  // Cancels pending async calls on destruction.
+  GCancellable* cancellable = g_cancellable_new();
 
  public:
   enum Status { Playing, Paused, Stopped };
@@ -22,7 +26,7 @@ class PlayerController {
   std::string artist;
   std::string artUrl;
   std::string trackId;
-  uint64_t duration;
+  uint64_t duration = 0;
   std::string bus;
 
   PlayerController(GDBusConnection* connection, const std::string& bus);
@@ -33,16 +37,27 @@ class PlayerController {
   void previous();
   void progress(uint8_t value);
   uint8_t progress();
+  // Microseconds.
+  uint64_t position();
+  // Without blocking main loop, "callback" doesn't run if player is destroyed first.
+  void position(const std::function<void(uint64_t)>& callback);
 };
 
 class MediaController {
   GDBusConnection* connection;
   int nameOwnerChangeSignal = 0;
-  std::function<void()> playersChangeCallback;
+  using PlayersChangeCallback =
+      std::function<void(const std::string& bus, bool added)>;
+  PlayersChangeCallback playersChangeCallback;
 
  public:
   MediaController();
   ~MediaController();
+  std::unique_ptr<PlayerController> getPlayer(const std::string& bus);
   std::vector<std::unique_ptr<PlayerController>> getPlayers();
-  void onPlayersChange(const std::function<void()>& callback);
-};
\ No newline at end of file
+  void onPlayersChange(const PlayersChangeCallback& callback);
+};
+
+// "media" command e.g. {"progress", "50"}.
+void mediaAction(PlayerController& player, const std::vector<std::string>& args,
+                 std::string& error);
\ No newline at end of file
@@ -4,6 +4,9 @@
 
 #include "network.h"
 
+#include "../metrics.h"
+#include "../trace.h"
+
 Network::Status getStatusEnum(int8_t value) {
   constexpr int8_t NM_STATE_CONNECTED_SITE = 60;
   constexpr int8_t NM_STATE_CONNECTED_LOCAL = 50;
@@ -18,6 +21,7 @@ Network::Status getStatusEnum(int8_t value) {
 
 GVariant *Network::getConnectionProperty(const std::string &name,
                                          const std::string &path) {
+  TRACE_SCOPE("dbus NetworkManager Get");
   GVariant *result = g_dbus_connection_call_sync(
       connection, "org.freedesktop.NetworkManager", path.c_str(),
       "org.freedesktop.DBus.Properties", "Get",
@@ -81,11 +85,13 @@ void Network::parseProperties(GVariantIter *properties) {
 Network::Network() {
   connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, nullptr);
 
+  TRACE_SCOPE("dbus NetworkManager GetAll");
   GVariant *result = g_dbus_connection_call_sync(
       connection, "org.freedesktop.NetworkManager",
       "/org/freedesktop/NetworkManager", "org.freedesktop.DBus.Properties",
       "GetAll", g_variant_new("(s)", "org.freedesktop.NetworkManager"), nullptr,
       G_DBUS_CALL_FLAGS_NONE, -1, nullptr, nullptr);
+  if (!result) return;  // NetworkManager not running.
   GVariantIter *properties;
   g_variant_get(result, "(a{sv})", &properties);
   g_variant_unref(result);
@@ -97,6 +103,9 @@ void Network::onPropertiesChange(GDBusConnection *connection,
                                  const gchar *sender, const gchar *path,
                                  const gchar *interface, const gchar *signal,
                                  GVariant *parameters, gpointer data) {
+  static Metrics::Counter& signals =
+      Metrics::counter("dbus_signals_total{component=\"network\"}");
+  signals.add();
   Network *_this = static_cast<Network *>(data);
   GVariantIter *properties;
   g_variant_get(parameters, "(&sa{sv}@as)", nullptr, &properties, nullptr);
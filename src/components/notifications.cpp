@@ -4,6 +4,7 @@
 
 #include "notifications.h"
 
+#include "../metrics.h"
 #include "../utils.h"
 
 #define DBUS_PATH "/org/freedesktop/Notifications"
@@ -69,6 +70,9 @@ void parseHints(GVariantIter *hints, Notification &notification) {
 
 void NotificationManager::handleNotify(GVariant *parameters,
                                        GDBusMethodInvocation *invocation) {
+  static Metrics::Counter& notifications =
+      Metrics::counter("notifications_total");
+  notifications.add();
   Notification notification = {};
   char *appName, *summery, *body;
   uint index;
@@ -93,6 +97,7 @@ void NotificationManager::handleNotify(GVariant *parameters,
     list.emplace_back(notification);
     index = list.size() - 1;
   }
+  measure();
   auto id = index + 1;
   g_dbus_method_invocation_return_value(invocation, g_variant_new("(u)", id));
 
@@ -179,11 +184,26 @@ void NotificationManager::remove(uint index, RemoveReason reason) {
   // todo: check if notification exist or not. because close can be triggered by anyone and any id.
   auto id = index + 1;
   list.erase(list.begin() + index);
+  measure();
   g_dbus_connection_emit_signal(connection, nullptr, DBUS_PATH, DBUS_NAME,
                                 "NotificationClosed",
                                 g_variant_new("(uu)", id, 2), nullptr);
 }
 
+void NotificationManager::measure() {
+  size_t bytes = list.capacity() * sizeof(Notification);
+  for (const auto &notification : list) {
+    bytes += notification.label.capacity() +
+             notification.description.capacity() +
+             notification.appName.capacity() + notification.appId.capacity() +
+             notification.imagePath.capacity() +
+             notification.actions.capacity() * sizeof(Notification::Action);
+    for (const auto &action : notification.actions)
+      bytes += action.id.capacity() + action.label.capacity();
+  }
+  memory.set(list.size(), bytes);
+}
+
 void NotificationManager::clear() {
   for (uint index = 0; index < list.size(); index++)
     remove(index, RemoveReason::USER_DISMISSED);
@@ -9,6 +9,8 @@
 #include <functional>
 #include <string>
 
+#include "../memory.h"
+
 struct Notification {
   std::string label;
   std::string description;
@@ -30,6 +32,7 @@ struct Notification {
 class NotificationManager {
   GDBusConnection *connection;
   uint ownerId;
+  Memory::Account<Memory::Tag::Notifications> memory;
   static void busNameAcquired(GDBusConnection *connection, const gchar *name,
                               gpointer data);
 
@@ -43,5 +46,7 @@ class NotificationManager {
   void remove(uint index, RemoveReason reason);
   void clear();
   void invoke(uint index, const std::string &action);
+  // Updates memory accounting after "list" changed.
+  void measure();
   std::function<void()> onChange;
 };
\ No newline at end of file
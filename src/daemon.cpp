@@ -4,19 +4,34 @@
 
 #include "daemon.h"
 
+#include <fcntl.h>
+#include <poll.h>
 #include <gio/gio.h>
 #include <gtk/gtk.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <csignal>
 
+#include "../extensions/launcher/launch-stats.h"
 #include "../extensions/launcher/launcher.h"
 #include "../extensions/panel/panel.h"
+#include "components/audio.h"
+#include "memory.h"
+#include "metrics.h"
+#include "probes.h"
+#include "process.h"
+#include "startup.h"
+#include "state.h"
 #include "theme.h"
+#include "trace.h"
 #include "utils.h"
+#include "watchdog.h"
 
 class FileWatcher {
   using Callback = std::function<void(GFileMonitorEvent)>;
@@ -49,17 +64,21 @@ class FileWatcher {
 namespace Extensions {
 std::unique_ptr<ExtensionManager> manager;
 
+void create(const std::string& name, std::string& error, bool activate) {
+  if (name == "panel")
+    manager->add(name, std::make_unique<Panel>(), activate);
+  else if (name == "launcher")
+    manager->add(name, std::make_unique<Launcher>(), activate);
+  else
+    manager->load(name, error, activate);
+}
+
 void loadOrUnload(const std::string& value, std::string& error) {
   std::string name = ExtensionManager::getName(value);
   auto it = manager->extensions.find(name);
-  if (it == manager->extensions.end()) {
-    if (name == "panel")
-      manager->add(name, std::make_unique<Panel>());
-    else if (name == "launcher")
-      manager->add(name, std::make_unique<Launcher>());
-    else
-      manager->load(name, error);
-  } else {
+  if (it == manager->extensions.end())
+    create(name, error, true);
+  else {
     if (it->second->keepAlive) {
       if (it->second->active)
         it->second->deactivate();
@@ -73,19 +92,80 @@ void loadOrUnload(const std::string& value, std::string& error) {
   }
 }
 
+// Loads extension kept by previous daemon. Inactive one is only constructed, so no window flashes.
+void restore(const std::string& name, bool active, std::string& error) {
+  create(name, error, active);
+}
+
 void initialize() { manager = std::make_unique<ExtensionManager>(); }
 
 void destroy() { manager.reset(); }
 }
 
 namespace Daemon {
+#ifdef DEV
+constexpr bool logToFile = false;
+#else
+constexpr bool logToFile = true;
+#endif
+
+// "{server socket},{state memfd},{client socket},{client format}" inherited from previous instance.
+#define HANDOFF_ENV "SYSTEM_UI_HANDOFF"
+
+struct Handoff {
+  struct ExtensionState {
+    std::string name;
+    bool active;
+    std::string state;
+  };
+  std::vector<ExtensionState> extensions;
+  // Still running children, exec keeps them ours.
+  std::vector<Process::Running> children;
+  // For client which asked for reload, sent by new instance once socket is adopted.
+  Ipc::Response reply;
+};
+std::map<std::string, std::string> restored;
+
 GIOChannel* channel;
 std::unique_ptr<FileWatcher> userCssWatcher;
 #ifdef DEV
 std::unique_ptr<FileWatcher> defaultCssWatcher;
 #endif
+std::unique_ptr<FileWatcher> appDataWatcher;
+std::unique_ptr<FileWatcher> userConfigWatcher;
+
+struct Connection {
+  GIOChannel* channel;
+  int socket;
+  uint readWatch = 0;
+  uint writeWatch = 0;
+  uint readTimeout = 0;
+  // Received bytes not forming complete message yet.
+  std::string input;
+  // Responses not accepted by socket yet.
+  std::string output;
+  bool broken = false;
+  // "watch" command.
+  uint subscription = 0;
+  uint8_t topics = 0;
+};
+std::map<int, std::unique_ptr<Connection>> connections;
+Metrics::Gauge& connectionsGauge = Metrics::gauge("connections");
+
+void disconnect(Connection* connection) {
+  if (connection->readWatch) g_source_remove(connection->readWatch);
+  if (connection->writeWatch) g_source_remove(connection->writeWatch);
+  if (connection->readTimeout) g_source_remove(connection->readTimeout);
+  if (connection->subscription) State::unsubscribe(connection->subscription);
+  // Socket is closed once watches release channel, see close_on_unref.
+  g_io_channel_unref(connection->channel);
+  connections.erase(connection->socket);
+  connectionsGauge.add(-1);
+}
 
 void destroy(int code) {
+  while (!connections.empty()) disconnect(connections.begin()->second.get());
+  State::destroy();
   if (channel) {
     g_io_channel_shutdown(channel, true,
                           nullptr);  // also closes internal socket
@@ -95,40 +175,411 @@ void destroy(int code) {
 #ifdef DEV
   defaultCssWatcher.reset();
 #endif
+  appDataWatcher.reset();
+  userConfigWatcher.reset();
+  Process::destroy();
   Theme::destroy();
   Extensions::destroy();
+  appData.flush();
+  Watchdog::stop();
+  Log::stop();
   exit(code);
 }
 
-void onRequest(const std::string& content, int client) {
-  auto respond = [client](const std::string&& key, const std::string& value,
-                          int code = 0) {
-    if (key == "error" && code == 0) code = 1;
-    std::string content = "{ \"" + key + "\": \"" + value +
-                          "\", \"code\": " + std::to_string(code) + " }";
-    send(client, content.c_str(), content.size(), 0);
+gboolean onServerEvent(GIOChannel* channel, GIOCondition condition,
+                       gpointer data);
+
+// Blocking, for replies that must be out before exec.
+bool sendAll(int socket, std::string_view output) {
+  while (!output.empty()) {
+    ssize_t sent = send(socket, output.data(), output.size(), MSG_NOSIGNAL);
+    if (sent > 0) {
+      output.remove_prefix(sent);
+      continue;
+    }
+    if (sent == -1 && errno == EINTR) continue;
+    if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      pollfd descriptor = {.fd = socket, .events = POLLOUT};
+      if (::poll(&descriptor, 1, userConfig.get().socketReadTimeout) > 0)
+        continue;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool sendResponse(int socket, const Ipc::Response& response,
+                  Ipc::Format format) {
+  std::string buffer, output;
+  Ipc::encode(response, format, buffer);
+  Ipc::frame(output, buffer, format);
+  return sendAll(socket, output);
+}
+
+/*
+  Replaces process with current binary keeping listening socket, so new clients never see connection refused.
+  Extensions' state goes in memfd. Requesting client's socket is inherited too, new instance sends it "response"
+  and closes it, or it gets error here if exec fails.
+  Other connections are closed (SOCK_CLOEXEC). Clients don't reconnect, e.g. "watch" and "system-ui -" end.
+*/
+void reload(Connection* connection, Ipc::Response response,
+            Ipc::Format format) {
+  auto fail = [&](const std::string& error) {
+    Log::error(error);
+    if (!response.error.empty()) response.error += "\n";
+    response.error += error;
+    if (!response.code) response.code = 1;
+    std::string buffer;
+    Ipc::encode(response, format, buffer);
+    Ipc::frame(connection->output, buffer, format);
+    sendAll(connection->socket, connection->output);
+    connection->output.clear();
   };
 
-  std::vector<std::string> args;
-  std::stringstream ss(content);
-  std::string arg;
-  while (ss >> arg) args.push_back(arg);
+  Handoff handoff;
+  for (const auto& [name, extension] : Extensions::manager->extensions)
+    handoff.extensions.push_back(
+        {name, extension->active, extension->onHandoff()});
+  handoff.children = Process::running();
+  handoff.reply = response;
+  if (!handoff.reply.info.empty()) handoff.reply.info += "\n";
+  handoff.reply.info += "Daemon reloaded.";
+  std::string buffer;
+  glz::write_beve(handoff, buffer);
+
+  int state = memfd_create("system-ui-handoff", 0);
+  bool saved = state != -1;
+  for (size_t written = 0; saved && written < buffer.size();) {
+    ssize_t result =
+        write(state, buffer.data() + written, buffer.size() - written);
+    if (result > 0)
+      written += result;
+    else if (result == -1 && errno != EINTR)
+      saved = false;
+  }
+  if (!saved) {
+    if (state != -1) close(state);
+    return fail("Unable to save daemon state.");
+  }
+
+  // Earlier responses on this connection go first. Client gone is no reason to cancel.
+  int client = sendAll(connection->socket, connection->output)
+                   ? connection->socket
+                   : -1;
+  connection->output.clear();
+
+  int server = g_io_channel_unix_get_fd(channel);
+  fcntl(server, F_SETFD, 0);
+  if (client != -1) fcntl(client, F_SETFD, 0);
+  std::string value = std::to_string(server) + "," + std::to_string(state) +
+                      "," + std::to_string(client) + "," +
+                      std::to_string((int)format);
+  setenv(HANDOFF_ENV, value.c_str(), true);
+
+  char* argv[] = {const_cast<char*>("system-ui"), const_cast<char*>("run"),
+                  const_cast<char*>("daemon"), nullptr};
+  appData.flush();
+  Watchdog::stop();
+  Log::stop();
+  execv("/proc/self/exe", argv);
+  int error = errno;
+
+  // Keep running old binary.
+  Log::start(logToFile);
+  Watchdog::start(userConfig.get().stallBudget);
+  unsetenv(HANDOFF_ENV);
+  fcntl(server, F_SETFD, FD_CLOEXEC);
+  if (client != -1) fcntl(client, F_SETFD, FD_CLOEXEC);
+  close(state);
+  fail("Unable to reload daemon. " + std::string(strerror(error)));
+}
 
-  if (args[0] == "run" || args[0] == "exit") {
-    if (content == "run daemon")
-      return respond("info", "Daemon already running.");
-    else if (content == "exit daemon") {
-      respond("info", "Daemon exited.");
-      destroy(EXIT_SUCCESS);
+// Read once at load, adopt() unsets variable while worker stages may still ask.
+const bool isReloaded = getenv(HANDOFF_ENV);
+bool reloaded() { return isReloaded; }
+
+std::string restore(const std::string& extension) {
+  auto it = restored.find(extension);
+  if (it == restored.end()) return "";
+  std::string state = std::move(it->second);
+  restored.erase(it);
+  return state;
+}
+
+// Takes over socket and state of previous instance.
+bool adopt(Handoff& handoff) {
+  int server = -1, state = -1, client = -1, format = 0;
+  sscanf(getenv(HANDOFF_ENV), "%d,%d,%d,%d", &server, &state, &client,
+         &format);
+  unsetenv(HANDOFF_ENV);
+  if (server < 0 || state < 0) return false;
+  fcntl(server, F_SETFD, FD_CLOEXEC);
+  channel = g_io_channel_unix_new(server);
+  uint watch = g_io_add_watch(channel, G_IO_IN, onServerEvent, nullptr);
+  g_source_set_name_by_id(watch, "daemon server");
+
+  struct stat info;
+  std::string buffer;
+  if (fstat(state, &info) == 0 && info.st_size > 0) {
+    void* memory = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, state, 0);
+    if (memory != MAP_FAILED) {
+      buffer.assign(static_cast<char*>(memory), info.st_size);
+      munmap(memory, info.st_size);
     }
+  }
+  close(state);
+
+  std::string error;
+  bool decoded = Ipc::decode(handoff, Ipc::Format::Beve, buffer, error);
+  if (!decoded) {
+    error = "Unable to restore daemon state. " + error;
+    Log::error(error);
+    handoff.reply = {.info = "Daemon reloaded.", .error = error, .code = 1};
+  }
+  if (client >= 0) {
+    sendResponse(client, handoff.reply, (Ipc::Format)format);
+    close(client);
+  }
+  // Socket adopted anyway.
+  if (!decoded) return true;
+  for (auto& extension : handoff.extensions)
+    restored[extension.name] = std::move(extension.state);
+  for (const auto& child : handoff.children)
+    Process::adopt(child.pid, child.command);
+  return true;
+}
 
+// Saves are renamed over file, so it shows up as created.
+bool isFileWritten(GFileMonitorEvent event) {
+  return event == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT ||
+         event == G_FILE_MONITOR_EVENT_CREATED;
+}
+
+void onAppDataChange() {
+  AppData previous;
+  if (!appData.reload(previous)) return;
+  AppData& data = appData.get();
+  if (data.lightMode != previous.lightMode) {
+    // Tones differ per mode, so regenerate from same seed.
+    std::string color = data.color;
+    // App data saved before seed was kept.
+    auto tone = data.theme.find("primary_40");
+    if (color.empty() && tone != data.theme.end()) color = tone->second;
+    Theme::apply(color.empty() ? Theme::defaultColor : color);
+  } else if (data.theme != previous.theme) {
+    Theme::apply();
+    for (const auto& it : Extensions::manager->extensions)
+      it.second->onThemeChange();
+  }
+  if (data.pinnedApps != previous.pinnedApps) {
+    for (const auto& it : Extensions::manager->extensions)
+      it.second->onAppDataChange();
+  }
+}
+
+void onUserConfigChange() {
+  UserConfig previous;
+  if (!userConfig.reload(previous)) return;
+  // Others are read on use.
+  if (userConfig.get().socketBacklog != previous.socketBacklog)
+    Log::info("socketBacklog applies after daemon restart.");
+  if (userConfig.get().stallBudget != previous.stallBudget) {
+    Watchdog::stop();
+    Watchdog::start(userConfig.get().stallBudget);
+  }
+}
+
+gboolean onClientWritable(GIOChannel* channel, GIOCondition condition,
+                          gpointer data);
+
+// Sends as much as socket accepts now, rest is sent when writable.
+void flush(Connection* connection) {
+  std::string& output = connection->output;
+  size_t sent = 0;
+  while (sent < output.size()) {
+    ssize_t result = send(connection->socket, output.data() + sent,
+                          output.size() - sent, MSG_NOSIGNAL);
+    if (result >= 0)
+      sent += result;
+    else if (errno == EINTR)
+      continue;
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+      break;
+    else {
+      connection->broken = true;
+      return;
+    }
+  }
+  output.erase(0, sent);
+  // Client stopped reading e.g. stuck "watch" subscriber.
+  if (output.size() > Ipc::maxMessageSize) {
+    connection->broken = true;
+    return;
+  }
+
+  if (!output.empty() && !connection->writeWatch) {
+    connection->writeWatch = g_io_add_watch(
+        connection->channel, G_IO_OUT, onClientWritable, connection);
+    g_source_set_name_by_id(connection->writeWatch, "daemon client write");
+  } else if (output.empty() && connection->writeWatch) {
+    g_source_remove(connection->writeWatch);
+    connection->writeWatch = 0;
+  }
+}
+
+gboolean onClientWritable(GIOChannel* channel, GIOCondition condition,
+                          gpointer data) {
+  auto connection = static_cast<Connection*>(data);
+  flush(connection);
+  if (connection->broken) disconnect(connection);
+  return G_SOURCE_CONTINUE;
+}
+
+void respond(Connection* connection, const Ipc::Response& response,
+             Ipc::Format format) {
+  std::string buffer;
+  Ipc::encode(response, format, buffer);
+  Ipc::frame(connection->output, buffer, format);
+  flush(connection);
+}
+
+void sendEvent(Connection* connection, State::Topic topic,
+               Ipc::Format format) {
+  respond(connection, {.data = State::snapshot(topic)}, format);
+}
+
+// Work to do after response is sent, e.g. exiting daemon.
+using Deferred = std::vector<std::function<void()>>;
+
+Ipc::Response run(const std::vector<std::string>& args, Connection* connection,
+                  Ipc::Format format, Deferred& deferred) {
+  auto respond = [](const std::string&& key, const std::string& value,
+                    int code = 0) {
+    Ipc::Response response;
+    if (key == "error") {
+      response.error = value;
+      response.code = code == 0 ? 1 : code;
+    } else
+      response.info = value;
+    return response;
+  };
+
+  if (args.empty()) return respond("error", "Empty command.");
+  TRACE_SCOPE("ipc " + args[0]);
+
+  // Round trip without work, e.g. "bench ipc".
+  if (args[0] == "ping") return respond("info", "pong");
+
+  if (args[0] == "run" || args[0] == "exit") {
+    if (args.size() < 2)
+      return respond("error", "Invalid amount of arguments.");
+    if (args[1] == "daemon") {
+      if (args[0] == "run") return respond("info", "Daemon already running.");
+      deferred.emplace_back([]() { destroy(EXIT_SUCCESS); });
+      return respond("info", "Daemon exited.");
+    }
     std::string error;
     Extensions::loadOrUnload(args[1], error);
-    if (error.empty())
-      respond("info", "");
-    else
-      respond("error", error);
-    return;
+    if (error.empty()) return respond("info", "");
+    return respond("error", error);
+  }
+
+  if (args[0] == "reload") {
+    if (args.size() != 2 || args[1] != "daemon")
+      return respond("error", "Only daemon can be reloaded.");
+    // Answered by reload() once exec succeeds or fails, see onRequest().
+    return {};
+  }
+
+  if (args[0] == "watch") {
+    uint8_t topics = 0;
+    for (size_t index = 1; index < args.size(); index++) {
+      State::Topic topic;
+      if (!State::parse(args[index], topic))
+        return respond("error", "Unknown topic '" + args[index] + "'.");
+      topics |= 1 << (uint8_t)topic;
+    }
+    if (!topics) topics = (1 << State::topics.size()) - 1;
+    connection->topics = topics;
+
+    if (!connection->subscription) {
+      connection->subscription =
+          State::subscribe([connection, format](State::Topic topic) {
+            if (!(connection->topics & (1 << (uint8_t)topic))) return;
+            sendEvent(connection, topic, format);
+            if (connection->broken) disconnect(connection);
+          });
+    }
+    // Current state first, then changes.
+    deferred.emplace_back([connection, format, topics]() {
+      for (State::Topic topic : State::topics) {
+        if (topics & (1 << (uint8_t)topic))
+          sendEvent(connection, topic, format);
+      }
+    });
+    return respond("info", "");
+  }
+
+  if (args[0] == "metrics") return respond("info", Metrics::dump());
+
+  if (args[0] == "logs") {
+    int count = args.size() > 1 ? std::atoi(args[1].c_str()) : 50;
+    if (count <= 0) return respond("error", "Invalid count '" + args[1] + "'.");
+    std::string lines;
+    for (const auto& record : Log::recent(count)) {
+      if (!lines.empty()) lines += "\n";
+      lines += Log::format(record);
+    }
+    return respond("info", lines);
+  }
+
+  if (args[0] == "trace") {
+    if (!Trace::enabled)
+      return respond("error", "Built without tracing. Rebuild with "
+                              "\"xmake f --tracing=y\".");
+    if (args.size() < 2 || args.size() > 3)
+      return respond("error", "Invalid amount of arguments.");
+    if (args[1] == "start") {
+      Trace::start();
+      return respond("info", "");
+    }
+    if (args[1] == "stop") {
+      std::string file = args.size() == 3 ? args[2] : TRACE_FILE;
+      // Daemon's working directory isn't client's.
+      if (!file.starts_with("/"))
+        return respond("error", "Trace file must be absolute path.");
+      std::string error;
+      if (!Trace::stop(file, error)) return respond("error", error);
+      return respond("info", file);
+    }
+    return respond("error", "Unknown trace '" + args[1] + "'.");
+  }
+
+  if (args[0] == "stats") {
+    if (args.size() != 2)
+      return respond("error", "Invalid amount of arguments.");
+    if (args[1] == "launch") return {.data = LaunchStats::query()};
+    if (args[1] == "memory") return {.data = Memory::query()};
+    return respond("error", "Unknown stats '" + args[1] + "'.");
+  }
+
+  if (args[0] == "get") {
+    if (args.size() != 2)
+      return respond("error", "Invalid amount of arguments.");
+    Ipc::Response response;
+    std::string error;
+    if (!State::query(args[1], response.data, error))
+      return respond("error", error);
+    return response;
+  }
+
+  if (args[0] == "media") {
+    PlayerController* player = State::activePlayer();
+    if (!player) return respond("error", "No active player found.");
+    std::string error;
+    mediaAction(*player, args, error);
+    if (error.empty()) return respond("info", "");
+    return respond("error", error);
   }
 
   if (args[0] == "theme") {
@@ -136,7 +587,6 @@ void onRequest(const std::string& content, int client) {
       return respond("error", "Invalid amount of arguments.");
 
     if (!validateHex(args[1]))
-      // Double quotes causes JSON parse error, so use single.
       return respond("error", "Invalid color '" + args[1] + "'.");
 
     auto it = std::find(args.begin(), args.end(), "--mode");
@@ -156,22 +606,170 @@ void onRequest(const std::string& content, int client) {
     return respond("info", "");
   }
 
-  respond("error", "Unhandled command.", 127);
+  return respond("error", "Unhandled command.", 127);
 }
 
-gboolean onServerEvent(GIOChannel* channel, GIOCondition condition,
-                       gpointer data) {
-  if (condition & G_IO_IN) {
-    int serverSocket = g_io_channel_unix_get_fd(channel);
-    int client = accept(serverSocket, nullptr, nullptr);
+bool isThemeCommand(const std::vector<std::string>& args) {
+  return args.size() >= 2 && args[0] == "theme" && validateHex(args[1]);
+}
 
-    char buffer[256];
-    ssize_t bytesRead = recv(client, buffer, sizeof(buffer) - 1, 0);
-    buffer[bytesRead] = '\0';
+std::string getMode(const std::vector<std::string>& args) {
+  auto it = std::find(args.begin(), args.end(), "--mode");
+  if (it != args.end() && std::next(it) != args.end()) return *std::next(it);
+  return "";
+}
 
-    onRequest(buffer, client);
+// Theme command with valid flags.
+bool isMergeable(const std::vector<std::string>& args) {
+  std::string mode = getMode(args);
+  return isThemeCommand(args) &&
+         (mode.empty() || mode == "light" || mode == "dark");
+}
 
-    close(client);
+// Consecutive theme commands only need last one, so one Theme::apply.
+std::vector<std::vector<std::string>> merge(
+    const std::vector<std::vector<std::string>>& commands) {
+  std::vector<std::vector<std::string>> result;
+  for (const auto& args : commands) {
+    // Last command's flags replace earlier ones, so earlier --mode is only dropped when overridden.
+    // Invalid ones run as is, so their error is reported and valid change isn't lost.
+    if (!result.empty() && isMergeable(result.back()) && isMergeable(args) &&
+        (getMode(result.back()).empty() || !getMode(args).empty()))
+      result.back() = args;
+    else
+      result.push_back(args);
+  }
+  return result;
+}
+
+void onRequest(const Ipc::Request& request, Connection* connection,
+               Ipc::Format format) {
+  // Socket, commands in batch.
+  PROBE2(request__receive, connection->socket, request.commands.size());
+  int64_t start = g_get_monotonic_time();
+  Ipc::Response response;
+  Deferred deferred;
+  if (request.commands.empty()) {
+    response.error = "Empty command.";
+    response.code = 1;
+  }
+
+  // Batch runs every command in order, like shell ";".
+  for (const auto& args : merge(request.commands)) {
+    Ipc::Response result = run(args, connection, format, deferred);
+    if (!result.info.empty()) {
+      if (!response.info.empty()) response.info += "\n";
+      response.info += result.info;
+    }
+    if (!result.error.empty()) {
+      if (!response.error.empty()) response.error += "\n";
+      response.error += result.error;
+      if (response.code == 0) response.code = result.code;
+    }
+    response.data.merge(result.data);
+  }
+  bool reloading = std::ranges::any_of(
+      request.commands, [](const std::vector<std::string>& args) {
+        return args.size() == 2 && args[0] == "reload" && args[1] == "daemon";
+      });
+  if (!reloading) respond(connection, response, format);
+  // Socket, exit code, queued output bytes.
+  PROBE3(request__respond, connection->socket, response.code,
+         connection->output.size());
+  static Metrics::Counter& requests = Metrics::counter("requests_total");
+  static Metrics::Counter& errors = Metrics::counter("request_errors_total");
+  static Metrics::Histogram& duration =
+      Metrics::histogram("request_duration_ms");
+  requests.add();
+  if (response.code) errors.add();
+  duration.observe((g_get_monotonic_time() - start) / 1000.0);
+  // Responds itself, from new instance if exec succeeds.
+  if (reloading) reload(connection, response, format);
+  for (const auto& callback : deferred) callback();
+}
+
+gboolean onClientReadable(GIOChannel* channel, GIOCondition condition,
+                          gpointer data) {
+  auto connection = static_cast<Connection*>(data);
+
+  bool closed = false;
+  char buffer[4096];
+  while (true) {
+    ssize_t received = recv(connection->socket, buffer, sizeof(buffer), 0);
+    if (received > 0)
+      connection->input.append(buffer, received);
+    else if (received < 0 && errno == EINTR)
+      continue;
+    else {
+      closed = received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+      break;
+    }
+  }
+
+  std::string_view input = connection->input;
+  std::string content;
+  Ipc::Format format;
+  bool invalid = false;
+  while (!connection->broken &&
+         Ipc::parse(input, content, format, invalid)) {
+    Ipc::Request request;
+    std::string error;
+    if (Ipc::decode(request, format, content, error))
+      onRequest(request, connection, format);
+    else
+      respond(connection, {.error = "Invalid request: " + error, .code = 1},
+              format);
+  }
+  connection->input.erase(0, connection->input.size() - input.size());
+
+  if (closed || invalid || connection->broken) {
+    // Watch is removed by returning, not by disconnect().
+    connection->readWatch = 0;
+    disconnect(connection);
+    return G_SOURCE_REMOVE;
+  }
+
+  // Partial message must complete in time, so stuck clients don't pile up.
+  if (connection->input.empty() && connection->readTimeout) {
+    g_source_remove(connection->readTimeout);
+    connection->readTimeout = 0;
+  } else if (!connection->input.empty() && !connection->readTimeout) {
+    connection->readTimeout = g_timeout_add(
+        userConfig.get().socketReadTimeout,
+        [](gpointer data) -> gboolean {
+          auto connection = static_cast<Connection*>(data);
+          Log::warn("Client read timed out.");
+          connection->readTimeout = 0;
+          disconnect(connection);
+          return G_SOURCE_REMOVE;
+        },
+        connection);
+    g_source_set_name_by_id(connection->readTimeout, "daemon client timeout");
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+gboolean onServerEvent(GIOChannel* channel, GIOCondition condition,
+                       gpointer data) {
+  int serverSocket = g_io_channel_unix_get_fd(channel);
+  while (true) {
+    int client =
+        accept4(serverSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client == -1) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      break;  // EAGAIN, no more pending.
+    }
+
+    auto connection = std::make_unique<Connection>();
+    connection->socket = client;
+    connection->channel = g_io_channel_unix_new(client);
+    g_io_channel_set_close_on_unref(connection->channel, true);
+    connection->readWatch = g_io_add_watch(
+        connection->channel, (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR),
+        onClientReadable, connection.get());
+    g_source_set_name_by_id(connection->readWatch, "daemon client read");
+    connections[client] = std::move(connection);
+    connectionsGauge.add(1);
   }
   return true;
 }
@@ -189,47 +787,22 @@ void startServer() {
 
   // SOCK_CLOEXEC ensures the socket is not unintentionally left open in child processes.
   // e.g. When launching app using posix_spawnp (launcher.cpp).
-  int server = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  int server = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
   if (bind(server, (struct sockaddr*)&address, sizeof(address)) == -1) {
     Log::error("Unable to bind daemon socket.");
     destroy(EXIT_FAILURE);
   }
-  // Max connection.
-  listen(server, 3);
+  // Pending connections queue. Bursts beyond it get ECONNREFUSED.
+  listen(server, userConfig.get().socketBacklog);
 
   channel = g_io_channel_unix_new(server);
-  g_io_add_watch(channel, G_IO_IN, onServerEvent, nullptr);
+  uint watch = g_io_add_watch(channel, G_IO_IN, onServerEvent, nullptr);
+  g_source_set_name_by_id(watch, "daemon server");
 }
 
-Response request(const std::string& content) {
-  struct sockaddr_un address;
-  memset(&address, 0, sizeof(address));
-  address.sun_family = AF_UNIX;
-  strcpy(address.sun_path, SOCKET_FILE.c_str());
-
-  Response response;
-  int client = socket(AF_UNIX, SOCK_STREAM, 0);
-  if (connect(client, (struct sockaddr*)&address, sizeof(address)) == -1) {
-    response.error = "Unable to connect daemon. Is it running?";
-    close(client);
-    return response;
-  }
-
-  send(client, content.c_str(), content.size(), 0);
-
-  char buffer[256];
-  memset(buffer, 0, sizeof(buffer));
-  ssize_t bytesRead = recv(client, buffer, sizeof(buffer) - 1, 0);
-  close(client);
-
-  if (strlen(buffer)) {
-    auto error = glz::read_json(response, buffer);
-    if (error)
-      response.error =
-          "Daemon responded invalid: " + glz::format_error(error, buffer);
-  } else
-    response.error = "Daemon did not respond. Crashed?";
-  return response;
+Response request(const std::vector<std::string>& args) {
+  Ipc::Client client;
+  return client.request(args);
 }
 
 void runInBackground() {
@@ -248,34 +821,109 @@ void runInBackground() {
 void onTerminateBySystem(int signal) { destroy(EXIT_SUCCESS); }
 
 void initialize() {
+  Handoff handoff;
 #ifndef DEV
-  runInBackground();
+  // Already in background.
+  if (!reloaded()) runInBackground();
 
   prepareDirectory(LOG_FILE);
-  Log::inFile = true;
 #endif
-  startServer();
-  std::signal(SIGTERM, onTerminateBySystem);
-
-  g_setenv("GDK_BACKEND", "wayland", true);
-  gtk_init(nullptr, nullptr);
-
-  // Don't apply theme or css before gtk_init().
-  // gdk_screen_get_default() is null before gtk_init.
-  Theme::apply();
-  userCssWatcher =
-      std::make_unique<FileWatcher>(USER_CSS, [](GFileMonitorEvent event) {
-        if (event == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT) Theme::apply();
-      });
+  // Before threads, see Process::initialize().
+  Process::initialize();
+  Log::start(logToFile);
+
+  // Bus connections are singletons, kept until components take them.
+  GDBusConnection* sessionBus = nullptr;
+  GDBusConnection* systemBus = nullptr;
+
+  Startup::run({
+      {.name = "config",
+       .run =
+           []() {
+             appData.get();
+             userConfig.get();
+           }},
+      {.name = "css", .run = Theme::preload},
+      {.name = "apps", .run = Launcher::preload},
+      {.name = "dbus",
+       .run =
+           [&]() {
+             sessionBus = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, nullptr);
+             systemBus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, nullptr);
+           }},
+      {.name = "pipewire", .run = Audio::initialize},
+      {.name = "server",
+       .after = {"config"},
+       .main = true,
+       .run =
+           [&]() {
+             if (!reloaded() || !adopt(handoff)) startServer();
+             std::signal(SIGTERM, onTerminateBySystem);
+           }},
+      {.name = "gtk",
+       .main = true,
+       .run =
+           []() {
+             g_setenv("GDK_BACKEND", "wayland", true);
+             gtk_init(nullptr, nullptr);
+           }},
+      // Don't apply theme or css before gtk_init().
+      // gdk_screen_get_default() is null before gtk_init.
+      {.name = "theme",
+       .after = {"gtk", "css", "config"},
+       .main = true,
+       .run =
+           []() {
+             Theme::apply();
+             userCssWatcher = std::make_unique<FileWatcher>(
+                 USER_CSS, [](GFileMonitorEvent event) {
+                   if (event == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT)
+                     Theme::apply();
+                 });
 #ifdef DEV
-  defaultCssWatcher =
-      std::make_unique<FileWatcher>(DEFAULT_CSS, [](GFileMonitorEvent event) {
-        if (event == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT) Theme::apply();
-      });
+             defaultCssWatcher = std::make_unique<FileWatcher>(
+                 DEFAULT_CSS, [](GFileMonitorEvent event) {
+                   if (event == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT)
+                     Theme::apply();
+                 });
 #endif
-
-  Extensions::initialize();
-
+           }},
+      {.name = "extensions",
+       .after = {"theme", "apps", "server"},
+       .main = true,
+       .run =
+           [&]() {
+             Extensions::initialize();
+             for (const auto& extension : handoff.extensions) {
+               std::string error;
+               Extensions::restore(extension.name, extension.active, error);
+               if (!error.empty()) Log::error(error);
+             }
+             restored.clear();
+           }},
+      {.name = "storage",
+       .after = {"extensions"},
+       .main = true,
+       .run =
+           []() {
+             appDataWatcher = std::make_unique<FileWatcher>(
+                 APP_DATA_FILE, [](GFileMonitorEvent event) {
+                   if (isFileWritten(event)) onAppDataChange();
+                 });
+             userConfigWatcher = std::make_unique<FileWatcher>(
+                 USER_CONFIG, [](GFileMonitorEvent event) {
+                   if (isFileWritten(event)) onUserConfigChange();
+                 });
+           }},
+      {.name = "state",
+       .after = {"extensions", "dbus", "pipewire"},
+       .main = true,
+       .run = State::initialize},
+  });
+  if (sessionBus) g_object_unref(sessionBus);
+  if (systemBus) g_object_unref(systemBus);
+
+  Watchdog::start(userConfig.get().stallBudget);
   gtk_main();
 }
 
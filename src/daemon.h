@@ -6,16 +6,18 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "extension.h"
+#include "ipc.h"
 
 namespace Daemon {
-struct Response {
-  std::string info;
-  std::string error;
-  uint8_t code;
-};
-Response request(const std::string& content);
+using Response = Ipc::Response;
+Response request(const std::vector<std::string>& args);
+// Started by "reload daemon" of previous instance.
+bool reloaded();
+// Extension state saved by previous instance, see Extension::onHandoff(). Empty otherwise.
+std::string restore(const std::string& extension);
 void initialize();
 }
 
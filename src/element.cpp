@@ -6,6 +6,9 @@
 
 #include <sstream>
 
+#include "metrics.h"
+#include "scheduler.h"
+#include "trace.h"
 #include "utils.h"
 
 Element::~Element() {
@@ -21,9 +24,17 @@ Element::~Element() {
 void Element::add(std::unique_ptr<Element> &&element) {
   gtk_container_add(GTK_CONTAINER(widget), element->widget);
   element->visible();
+  element->own(owner);
   childrens.emplace_back(std::move(element));
 }
 
+void Element::own(Memory::Owner owner) {
+  this->owner = owner;
+  memory.attribute(owner);
+  cssMemory.attribute(owner);
+  for (const auto &child : childrens) child->own(owner);
+}
+
 void Element::visible(bool value) { gtk_widget_set_visible(widget, value); }
 
 void Element::addClass(const std::string &classNames) {
@@ -53,6 +64,7 @@ void Element::style(const std::string &value) {
     g_error_free(error);
   } else {
     css = value;
+    cssMemory.set(1, value.size());
   }
 }
 
@@ -168,6 +180,20 @@ void VisibilityEvents::onHide(const std::function<void()> &callback) {
   g_signal_connect(widget, "hide", G_CALLBACK(+hide), this);
 }
 
+void VisibilityEvents::onUnmap(const std::function<void()> &callback) {
+  // Connected once, later calls only replace callback.
+  bool connected = bool(unmapCallback);
+  unmapCallback = callback;
+  if (connected) return;
+  auto unmap = [](GtkWidget *widget, GdkEvent *event,
+                  gpointer data) -> gboolean {
+    VisibilityEvents *_this = static_cast<VisibilityEvents *>(data);
+    _this->unmapCallback();
+    return GDK_EVENT_PROPAGATE;
+  };
+  g_signal_connect(widget, "unmap-event", G_CALLBACK(+unmap), this);
+}
+
 Box::Box(GtkOrientation orientation) {
   widget = gtk_box_new(orientation, 0);
   spaceEvenly(false);
@@ -184,6 +210,7 @@ void Box::spaceEvenly(bool value) {
 void Box::prependChild(std::unique_ptr<Element> &&child) {
   gtk_box_pack_start((GtkBox *)widget, child->widget, true, true, 0);
   child->visible();
+  child->own(owner);
   childrens.emplace_back(std::move(child));
 }
 
@@ -198,6 +225,11 @@ void Label::set(const std::string &value) {
 
 Icon::Icon() { addClass("icon"); }
 
+void Icon::own(Memory::Owner owner) {
+  Box::own(owner);
+  imageMemory.attribute(owner);
+}
+
 void Icon::set(const std::string &name) {
   if (!label) {
     auto _label = std::make_unique<Label>();
@@ -210,6 +242,10 @@ void Icon::set(const std::string &name) {
 void Icon::setImage(const std::string &path) {
   GtkStyleContext *context = gtk_widget_get_style_context(widget);
   if (!gtk_style_context_has_class(context, "image")) addClass("image");
+  // Decoded by GTK, file size is lower bound.
+  std::error_code error;
+  auto bytes = std::filesystem::file_size(path, error);
+  imageMemory.set(1, error ? 0 : bytes);
   style("* { background-image: url(\"" + path + "\"); }");
 }
 
@@ -495,6 +531,7 @@ Menu::Menu() { widget = gtk_menu_new(); }
 void Menu::add(std::unique_ptr<Element> &&child) {
   gtk_menu_shell_append((GtkMenuShell *)widget, child->widget);
   child->visible();
+  child->own(owner);
   childrens.emplace_back(std::move(child));
 }
 
@@ -502,36 +539,48 @@ void Menu::visible(bool value) {
   if (value) gtk_menu_popup_at_pointer((GtkMenu *)widget, nullptr);
 }
 
-gboolean Transition::update(gpointer data) {
-  Transition *_this = static_cast<Transition *>(data);
-  _this->currentSteps--;
-  if (_this->currentSteps > 0) {
-    _this->current.width += _this->stepWidth;
-    _this->current.height += _this->stepHeight;
-    _this->element->size(_this->current.width, _this->current.height);
-    return G_SOURCE_CONTINUE;
+void Transition::update() {
+  // Ticks arriving late mean frames skipped, e.g. main loop busy.
+  int64_t now = g_get_monotonic_time();
+  int64_t frames = (now - lastFrame) / int64_t(timeoutMs * 1000);
+  static Metrics::Counter& dropped = Metrics::counter("dropped_frames_total");
+  if (frames > 1) dropped.add(frames - 1);
+  lastFrame = now;
+  currentSteps--;
+  if (currentSteps > 0) {
+    current.width += stepWidth;
+    current.height += stepHeight;
+    element->size(current.width, current.height);
   } else {
-    for (const auto &child : _this->element->childrens) child->visible();
-    _this->element->size(-1, -1);  // revert dynamic sizing
-    _this->finishCallback();
-    return G_SOURCE_REMOVE;
+    Scheduler::cancel(timeout);
+    timeout = 0;
+    for (const auto &child : element->childrens) child->visible();
+    element->size(-1, -1);  // revert dynamic sizing
+    if constexpr (Trace::enabled) Trace::record("transition", traceBegin);
+    finishCallback();
   }
 }
 
 void Transition::to(Frame to, const std::function<void()> &onFinish) {
   if (currentSteps > 0) {
-    g_source_remove(timeout);
+    Scheduler::cancel(timeout);
   } else {
+    if constexpr (Trace::enabled) traceBegin = Trace::now();
     current.width = gtk_widget_get_allocated_width(element->widget);
     current.height = gtk_widget_get_allocated_height(element->widget);
     // children prevents parent size change. so hide while transitioning.
     for (const auto &child : element->childrens) child->visible(false);
   }
   finishCallback = onFinish;
+  lastFrame = g_get_monotonic_time();
   currentSteps = duration / timeoutMs;
   stepWidth = (to.width - current.width) / currentSteps;
   stepHeight = (to.height - current.height) / currentSteps;
-  timeout = g_timeout_add(timeoutMs, update, this);
+  timeout = Scheduler::every(timeoutMs, [this]() { update(); });
 }
 
-Transition::Transition(Element *element) : element(element) {}
\ No newline at end of file
+Transition::Transition(Element *element) : element(element) {}
+
+Transition::~Transition() {
+  if (currentSteps > 0) Scheduler::cancel(timeout);
+}
\ No newline at end of file
@@ -11,11 +11,18 @@
 #include <functional>
 #include <memory>
 
+#include "memory.h"
+
 enum class Align { Top, Bottom, Start, End, Center };
 enum class ScrollDirection { Up, Down };
 
 class Element {
   GtkCssProvider *cssProvider = nullptr;
+  Memory::Account<Memory::Tag::Elements> memory{1, sizeof(Element)};
+  Memory::Account<Memory::Tag::Css> cssMemory;
+
+ protected:
+  Memory::Owner owner = Memory::current();
 
  public:
   // virtual destructor fixes diamond problem undefined behaivour.
@@ -26,6 +33,8 @@ class Element {
   std::string css;
 
   void add(std::unique_ptr<Element> &&element);
+  // Attributes memory of this tree to extension "owner". Children added later follow parent.
+  virtual void own(Memory::Owner owner);
   virtual void visible(bool value = true);
   void addClass(const std::string &classNames);
   void removeClass(const std::string &className);
@@ -81,9 +90,12 @@ class KeyboardEvents : virtual public Element {
 
 class VisibilityEvents : public virtual Element {
   std::function<void()> hideCallback;
+  std::function<void()> unmapCallback;
 
  public:
   void onHide(const std::function<void()> &callback);
+  // Window unmapped by windowing system, unlike "hide" which is GTK side.
+  void onUnmap(const std::function<void()> &callback);
 };
 
 class Box : public Element {
@@ -101,9 +113,12 @@ class Label : public Element {
 };
 
 class Icon : public Box {
+  Memory::Account<Memory::Tag::Icons> imageMemory;
+
  public:
   Label *label = nullptr;
   Icon();
+  void own(Memory::Owner owner) override;
   void set(const std::string &name);
   void setImage(const std::string &path);
 };
@@ -182,7 +197,7 @@ class EventBox : public PointerEvents,
   EventBox();
 };
 
-class Window : public EventBox {
+class Window : public EventBox, public VisibilityEvents {
  public:
   Window(GtkWindowType type, GtkLayerShellKeyboardMode keyboardMode =
                                  GTK_LAYER_SHELL_KEYBOARD_MODE_NONE);
@@ -222,8 +237,10 @@ class Menu : public VisibilityEvents {
 
 class Transition {
   static constexpr float timeoutMs = 16.67;  // 1000 / 60fps
-  int timeout = 0;
+  uint timeout = 0;
   int16_t currentSteps = 0;
+  int64_t traceBegin = 0;
+  int64_t lastFrame;
   int16_t stepWidth;
   int16_t stepHeight;
   Element *element;
@@ -236,7 +253,8 @@ class Transition {
   };
   Frame current;
   int16_t duration;
-  static gboolean update(gpointer data);
+  void update();
   void to(Frame to, const std::function<void()> &onFinish);
   Transition(Element *element);
+  ~Transition();
 };
\ No newline at end of file
@@ -6,10 +6,19 @@
 
 #include <dlfcn.h>
 
+#include "memory.h"
+#include "metrics.h"
+#include "trace.h"
 #include "utils.h"
 
 void Extension::activate() {
+  TRACE_SCOPE("extension activate");
+  static Metrics::Counter& activations =
+      Metrics::counter("extension_activations_total");
+  activations.add();
   active = true;
+  // Elements built here and trees they grow into count toward this extension.
+  Memory::Scope scope(name);
   onActivate();
 }
 
@@ -44,9 +53,11 @@ bool ExtensionManager::needsReload(
 }
 
 void ExtensionManager::add(const std::string& name,
-                           std::unique_ptr<Extension>&& extension) {
+                           std::unique_ptr<Extension>&& extension,
+                           bool activate) {
+  extension->name = name;
   extensions[name] = std::move(extension);
-  extensions[name]->activate();
+  if (activate) extensions[name]->activate();
 }
 
 std::filesystem::path findFile(const std::string& name) {
@@ -63,7 +74,9 @@ std::filesystem::path findFile(const std::string& name) {
   return file;
 }
 
-void ExtensionManager::load(const std::string& name, std::string& error) {
+void ExtensionManager::load(const std::string& name, std::string& error,
+                            bool activate) {
+  TRACE_SCOPE("extension load " + name);
   std::filesystem::path file = findFile(name);
   if (file.empty()) {
     error = name + " not found in " + EXTENSIONS_DIR;
@@ -83,7 +96,9 @@ void ExtensionManager::load(const std::string& name, std::string& error) {
     return;
   }
 
-  add(name, createExtension());
+  static Metrics::Counter& loads = Metrics::counter("extension_loads_total");
+  loads.add();
+  add(name, createExtension(), activate);
   auto& extension = extensions[name];
   extension->handle = handle;
   extension->filename = file.filename();
@@ -23,8 +23,15 @@ class Extension {
   virtual ~Extension() = default;
 
   virtual void onThemeChange(){};
+  // App data changed outside daemon, e.g. pinned apps edited by hand.
+  virtual void onAppDataChange(){};
+
+  // State passed to next instance on "reload daemon", e.g. cached entries.
+  // Extension gets it back by Daemon::restore() in constructor.
+  virtual std::string onHandoff() { return ""; };
 
   // Internally used.
+  std::string name;
   bool active = false;
   void activate();
   void deactivate();
@@ -38,8 +45,10 @@ class ExtensionManager {
   std::map<std::string, std::unique_ptr<Extension>> extensions;
   static std::string getName(std::string filename);
   static bool needsReload(const std::unique_ptr<Extension>& extension);
-  void add(const std::string& name, std::unique_ptr<Extension>&& extension);
-  void load(const std::string& name, std::string& error);
+  // "activate" false only constructs, e.g. restoring inactive extension.
+  void add(const std::string& name, std::unique_ptr<Extension>&& extension,
+           bool activate = true);
+  void load(const std::string& name, std::string& error, bool activate = true);
   void unload(const std::string& name);
   ~ExtensionManager();
 };
@@ -0,0 +1,142 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#include "ipc.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "utils.h"
+
+namespace Ipc {
+bool sendAll(int socket, const char* data, size_t size) {
+  while (size > 0) {
+    // MSG_NOSIGNAL prevents SIGPIPE killing process when other side disconnects.
+    ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+bool receiveAll(int socket, char* data, size_t size) {
+  while (size > 0) {
+    ssize_t received = recv(socket, data, size, 0);
+    if (received < 0 && errno == EINTR) continue;
+    if (received <= 0) return false;
+    data += received;
+    size -= received;
+  }
+  return true;
+}
+
+void frame(std::string& output, std::string_view content, Format format) {
+  Header header = {.size = static_cast<uint32_t>(content.size()),
+                   .format = format};
+  output.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  output.append(content);
+}
+
+bool parse(std::string_view& input, std::string& content, Format& format,
+           bool& invalid) {
+  if (input.size() < sizeof(Header)) return false;
+  Header header;
+  memcpy(&header, input.data(), sizeof(header));
+  if (header.size > maxMessageSize ||
+      (header.format != Format::Beve && header.format != Format::Json)) {
+    invalid = true;
+    return false;
+  }
+  if (input.size() < sizeof(header) + header.size) return false;
+  format = header.format;
+  content.assign(input.substr(sizeof(header), header.size));
+  input.remove_prefix(sizeof(header) + header.size);
+  return true;
+}
+
+bool write(int socket, std::string_view content, Format format) {
+  if (content.size() > maxMessageSize) return false;
+  std::string output;
+  frame(output, content, format);
+  return sendAll(socket, output.data(), output.size());
+}
+
+bool read(int socket, std::string& content, Format& format) {
+  Header header;
+  if (!receiveAll(socket, reinterpret_cast<char*>(&header), sizeof(header)))
+    return false;
+  if (header.size > maxMessageSize) return false;
+  format = header.format;
+  content.resize(header.size);
+  return receiveAll(socket, content.data(), header.size);
+}
+
+Client::~Client() {
+  if (socket != -1) close(socket);
+}
+
+bool Client::connected() { return socket != -1; }
+
+bool Client::connect(std::string& error) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, SOCKET_FILE.c_str());
+
+  socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (::connect(socket, (struct sockaddr*)&address, sizeof(address)) == -1) {
+    error = "Unable to connect daemon. Is it running?";
+    close(socket);
+    socket = -1;
+    return false;
+  }
+  return true;
+}
+
+Response Client::request(const std::vector<std::string>& args) {
+  Response response;
+  if (!connected() && !connect(response.error)) return response;
+
+  Request request = {.commands = {{}}};
+  // Only standalone ";" separates, so arguments ending in ";" stay intact.
+  for (const std::string& arg : args) {
+    if (arg == ";")
+      request.commands.emplace_back();
+    else
+      request.commands.back().push_back(arg);
+  }
+  std::erase_if(request.commands,
+                [](const std::vector<std::string>& args) { return args.empty(); });
+
+  encode(request, format, buffer);
+  Format responseFormat;
+  if (!write(socket, buffer, format) ||
+      !read(socket, buffer, responseFormat)) {
+    close(socket);
+    socket = -1;
+    response.error = "Daemon did not respond. Crashed?";
+    return response;
+  }
+
+  std::string error;
+  if (!decode(response, responseFormat, buffer, error))
+    response.error = "Daemon responded invalid: " + error;
+  return response;
+}
+
+bool Client::receive(Response& response) {
+  Format responseFormat;
+  std::string error;
+  if (!connected() || !read(socket, buffer, responseFormat)) return false;
+  return decode(response, responseFormat, buffer, error);
+}
+}
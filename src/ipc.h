@@ -0,0 +1,91 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "glaze/beve.hpp"
+#include "glaze/json.hpp"
+
+/*
+  Daemon socket protocol.
+  Every message is a Header followed by "size" bytes of Request or Response encoded in "format".
+  Connections are persistent, client can send any number of requests and each gets exactly one response in order.
+  Daemon responds in the same format as request. JSON is meant for debugging e.g. "system-ui --json theme 67abe8".
+*/
+namespace Ipc {
+enum class Format : uint8_t { Beve, Json };
+
+struct Header {
+  uint32_t size;
+  Format format;
+  uint8_t reserved[3] = {};
+};
+constexpr uint32_t maxMessageSize = 16 * 1024 * 1024;
+
+// Blocking.
+bool write(int socket, std::string_view content, Format format);
+bool read(int socket, std::string& content, Format& format);
+
+// Non-blocking helpers for buffered sockets.
+void frame(std::string& output, std::string_view content, Format format);
+/*
+  Takes one complete message from front of "input" and advances it.
+  Returns false when more bytes are needed, or sets "invalid" when header is malformed.
+*/
+bool parse(std::string_view& input, std::string& content, Format& format,
+           bool& invalid);
+
+struct Request {
+  // Batch, e.g. "theme 67abe8 --mode dark ; run panel" is two commands.
+  std::vector<std::vector<std::string>> commands;
+};
+
+struct Response {
+  std::string info;
+  std::string error;
+  uint8_t code = 0;
+  // Structured payload e.g. state queries.
+  std::map<std::string, std::string> data;
+};
+
+template <typename Message>
+void encode(const Message& message, Format format, std::string& buffer) {
+  if (format == Format::Json)
+    glz::write_json(message, buffer);
+  else
+    glz::write_beve(message, buffer);
+}
+
+template <typename Message>
+bool decode(Message& message, Format format, const std::string& buffer,
+            std::string& error) {
+  auto result = format == Format::Json ? glz::read_json(message, buffer)
+                                       : glz::read_beve(message, buffer);
+  if (result) error = glz::format_error(result, buffer);
+  return !result;
+}
+
+class Client {
+  int socket = -1;
+
+ public:
+  Format format = Format::Beve;
+  // Raw response of last request, useful with Format::Json.
+  std::string buffer;
+
+  ~Client();
+  bool connect(std::string& error);
+  bool connected();
+  // Splits "args" into batch on ";".
+  Response request(const std::vector<std::string>& args);
+  // Waits for next message not requested e.g. "watch" events.
+  bool receive(Response& response);
+};
+}
@@ -0,0 +1,111 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#include "memory.h"
+
+#include <malloc.h>
+
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace Memory {
+constexpr size_t tagCount = static_cast<size_t>(Tag::Count);
+constexpr std::array<const char*, tagCount> names = {
+    "launcher", "elements", "css", "icons", "notifications", "pipewire"};
+
+// Further extensions share last slot.
+constexpr size_t maxOwners = 16;
+// Index is Owner, first is daemon.
+std::vector<std::string> owners = {""};
+thread_local Owner currentOwner = 0;
+
+struct Counter {
+  std::atomic<int64_t> objects = 0;
+  std::atomic<int64_t> bytes = 0;
+};
+std::array<std::array<Counter, tagCount>, maxOwners> counters;
+
+Owner owner(const std::string& name) {
+  for (size_t index = 0; index < owners.size(); index++)
+    if (owners[index] == name) return index;
+  if (owners.size() == maxOwners) return maxOwners - 1;
+  owners.push_back(name);
+  return owners.size() - 1;
+}
+
+Owner current() { return currentOwner; }
+
+Scope::Scope(const std::string& name) : previous(currentOwner) {
+  currentOwner = owner(name);
+}
+
+Scope::~Scope() { currentOwner = previous; }
+
+void count(Tag tag, Owner owner, int64_t objects, int64_t bytes) {
+  Counter& counter = counters[owner][static_cast<size_t>(tag)];
+  counter.objects.fetch_add(objects, std::memory_order_relaxed);
+  counter.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+std::string size(int64_t bytes) {
+  constexpr std::array<const char*, 4> units = {"B", "KiB", "MiB", "GiB"};
+  double value = bytes;
+  size_t unit = 0;
+  while (std::abs(value) >= 1024 && unit < units.size() - 1) {
+    value /= 1024;
+    unit++;
+  }
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(unit ? 1 : 0) << value << " "
+      << units[unit];
+  return oss.str();
+}
+
+std::map<std::string, std::string> query() {
+  std::map<std::string, std::string> result;
+
+  // Kernel's totals over all mappings, PSS splits shared pages between sharers.
+  std::ifstream rollup("/proc/self/smaps_rollup");
+  std::string line;
+  while (std::getline(rollup, line)) {
+    for (const char* key : {"Rss", "Pss"}) {
+      std::string prefix = std::string(key) + ":";
+      if (!line.starts_with(prefix)) continue;
+      std::string name = key;
+      for (char& c : name) c = std::tolower(c);
+      result[name] = size(std::stoll(line.substr(prefix.size())) * 1024);
+    }
+  }
+
+  struct mallinfo2 info = mallinfo2();
+  result["heap"] = size(info.uordblks) + " used, " + size(info.fordblks) +
+                   " free";
+
+  auto format = [](int64_t objects, int64_t bytes) {
+    return std::to_string(objects) + " objects, " + size(bytes);
+  };
+  for (size_t index = 0; index < tagCount; index++) {
+    int64_t objects = 0;
+    int64_t bytes = 0;
+    for (size_t owner = 0; owner < owners.size(); owner++) {
+      const Counter& counter = counters[owner][index];
+      int64_t ownerObjects = counter.objects.load();
+      int64_t ownerBytes = counter.bytes.load();
+      objects += ownerObjects;
+      bytes += ownerBytes;
+      if (owner && (ownerObjects || ownerBytes))
+        result[std::string(names[index]) + "/" + owners[owner]] =
+            format(ownerObjects, ownerBytes);
+    }
+    result[names[index]] = format(objects, bytes);
+  }
+  return result;
+}
+}
@@ -0,0 +1,84 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/*
+  Per subsystem memory accounting for "stats memory", next to process RSS/PSS.
+  Owners report own objects and estimated bytes through Account, so counts drop once owner is freed.
+  Accounts are also attributed to extension they were created for, see Scope, and listed per extension.
+  GTK and GLib internal allocations aren't included, e.g. widget memory behind Element.
+*/
+namespace Memory {
+enum class Tag : uint8_t {
+  Launcher,
+  Elements,
+  Css,
+  Icons,
+  Notifications,
+  PipeWire,
+  Count
+};
+
+// Extension accounts are attributed to, 0 is daemon itself.
+using Owner = uint8_t;
+// Id for extension "name", registered on first use. Main thread.
+Owner owner(const std::string& name);
+// Owner of accounts created on this thread now.
+Owner current();
+
+// Attributes accounts created within to "name", e.g. while extension builds its elements.
+class Scope {
+  Owner previous;
+
+ public:
+  Scope(const std::string& name);
+  ~Scope();
+};
+
+// Atomic, PipeWire thread counts too.
+void count(Tag tag, Owner owner, int64_t objects, int64_t bytes);
+
+// Owner's share of "tag", released on destruction.
+template <Tag tag>
+class Account {
+  int64_t objects = 0;
+  int64_t bytes = 0;
+  Owner owner = current();
+
+ public:
+  Account() = default;
+  Account(int64_t objects, int64_t bytes) { set(objects, bytes); }
+  Account(const Account& other) : Account(other.objects, other.bytes) {}
+  Account& operator=(const Account& other) {
+    set(other.objects, other.bytes);
+    return *this;
+  }
+  ~Account() { set(0, 0); }
+
+  void set(int64_t objects, int64_t bytes) {
+    count(tag, owner, objects - this->objects, bytes - this->bytes);
+    this->objects = objects;
+    this->bytes = bytes;
+  }
+
+  // Moves share to "owner", e.g. element added to extension's tree.
+  void attribute(Owner owner) {
+    if (owner == this->owner) return;
+    count(tag, this->owner, -objects, -bytes);
+    count(tag, owner, objects, bytes);
+    this->owner = owner;
+  }
+};
+
+/*
+  "stats memory" command, e.g. "rss" -> "48.2 MiB", "elements" -> "412 objects, 0 B".
+  Extension's share is listed too, e.g. "elements/panel" -> "230 objects, 0 B".
+*/
+std::map<std::string, std::string> query();
+}
@@ -0,0 +1,157 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#include "metrics.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+#include "utils.h"
+
+namespace Metrics {
+constexpr const char* prefix = "system_ui_";
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<Metric*> metrics;
+};
+
+// Never destroyed, so metrics destroyed at exit can still unregister.
+Registry& registry() {
+  static Registry* instance = new Registry;
+  return *instance;
+}
+
+Metric::Metric(std::string_view name, bool listed) : name(name) {
+  if (!listed) return;
+  Registry& registry = Metrics::registry();
+  std::lock_guard lock(registry.mutex);
+  registry.metrics.push_back(this);
+}
+
+Metric::~Metric() {
+  Registry& registry = Metrics::registry();
+  std::lock_guard lock(registry.mutex);
+  std::erase(registry.metrics, this);
+}
+
+// Family and labels split from name, e.g. "foo_total{a=\"1\"}".
+std::pair<std::string, std::string> split(const std::string& name) {
+  size_t brace = name.find('{');
+  if (brace == std::string::npos) return {name, ""};
+  return {name.substr(0, brace),
+          name.substr(brace + 1, name.size() - brace - 2)};
+}
+
+// Family is listed as other type already, e.g. counter "x" and gauge "x{a=\"1\"}".
+template <typename Type>
+bool conflicts(const std::string& name) {
+  std::string family = split(name).first;
+  Registry& registry = Metrics::registry();
+  std::lock_guard lock(registry.mutex);
+  for (const Metric* metric : registry.metrics)
+    if (!dynamic_cast<const Type*>(metric) &&
+        split(metric->name).first == family)
+      return true;
+  return false;
+}
+
+// Across types, so conflict check and registration are one step.
+std::mutex findMutex;
+
+template <typename Type>
+Type& find(std::string_view name) {
+  static std::map<std::string, std::unique_ptr<Type>, std::less<>> owned;
+  std::lock_guard lock(findMutex);
+  auto it = owned.find(name);
+  if (it != owned.end()) return *it->second;
+  std::string key(name);
+  bool listed = !conflicts<Type>(key);
+  // Still usable by caller, just not dumped.
+  if (!listed)
+    Log::error("Metric " + key + " already registered as other type.");
+  return *owned.emplace(key, std::make_unique<Type>(key, listed))
+              .first->second;
+}
+
+Counter& counter(std::string_view name) { return find<Counter>(name); }
+
+Gauge& gauge(std::string_view name) { return find<Gauge>(name); }
+
+Histogram& histogram(std::string_view name) { return find<Histogram>(name); }
+
+std::string number(double value) {
+  std::ostringstream oss;
+  oss << value;
+  return oss.str();
+}
+
+// "labels" with "extra" label appended, in braces.
+std::string join(const std::string& labels, const std::string& extra = "") {
+  std::string all = labels;
+  if (!extra.empty()) all += (all.empty() ? "" : ",") + extra;
+  return all.empty() ? "" : "{" + all + "}";
+}
+
+void Counter::write(std::string& output, const std::string& family,
+                    const std::string& labels) const {
+  output += family + join(labels) + " " + std::to_string(value.load()) + "\n";
+}
+
+void Gauge::write(std::string& output, const std::string& family,
+                  const std::string& labels) const {
+  output += family + join(labels) + " " + std::to_string(value.load()) + "\n";
+}
+
+void Histogram::write(std::string& output, const std::string& family,
+                      const std::string& labels) const {
+  // Prometheus buckets are cumulative.
+  uint64_t count = 0;
+  for (size_t index = 0; index < buckets.size(); index++) {
+    count += buckets[index].load();
+    std::string bound =
+        index < bounds.size() ? number(bounds[index]) : std::string("+Inf");
+    output += family + "_bucket" + join(labels, "le=\"" + bound + "\"") + " " +
+              std::to_string(count) + "\n";
+  }
+  output += family + "_sum" + join(labels) + " " + number(sum.load()) + "\n";
+  output += family + "_count" + join(labels) + " " + std::to_string(count) +
+            "\n";
+}
+
+std::string dump() {
+  Registry& registry = Metrics::registry();
+  // Held while writing, so no metric is destroyed meanwhile.
+  std::lock_guard lock(registry.mutex);
+  struct Entry {
+    std::string family;
+    std::string labels;
+    const Metric* metric;
+  };
+  std::vector<Entry> entries;
+  for (const Metric* metric : registry.metrics) {
+    auto [family, labels] = split(metric->name);
+    entries.push_back({prefix + family, labels, metric});
+  }
+  // By family first, so foo_total_x can't split foo_total from foo_total{...}.
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return std::tie(a.family, a.labels) < std::tie(b.family, b.labels);
+  });
+
+  std::string output;
+  std::string lastFamily;
+  for (const Entry& entry : entries) {
+    if (entry.family != lastFamily) {
+      output += "# TYPE " + entry.family + " " + entry.metric->type() + "\n";
+      lastFamily = entry.family;
+    }
+    entry.metric->write(output, entry.family, entry.labels);
+  }
+  return output;
+}
+}
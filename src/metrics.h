@@ -0,0 +1,100 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+  Process wide metrics for "system-ui metrics", Prometheus text format e.g. for node-exporter textfile collector.
+  Metrics are owned by daemon, looked up by name once and kept as reference:
+    static Metrics::Counter& requests = Metrics::counter("requests_total");
+    requests.add();
+  Extensions must use these lookups rather than own Metric objects, so nothing in their .so outlives dlclose().
+  Names get "system_ui_" prefix. Labels go in name, metrics sharing name before "{" form one family.
+  Updates are relaxed atomics, safe from any thread.
+*/
+namespace Metrics {
+class Metric {
+ public:
+  const std::string name;
+  // Registered until destroyed, unless not "listed".
+  Metric(std::string_view name, bool listed = true);
+  virtual ~Metric();
+  Metric(const Metric&) = delete;
+  virtual const char* type() const = 0;
+  // Appends sample lines, "family" and "labels" split from name.
+  virtual void write(std::string& output, const std::string& family,
+                     const std::string& labels) const = 0;
+};
+
+class Counter : public Metric {
+  std::atomic<uint64_t> value = 0;
+
+ public:
+  using Metric::Metric;
+  void add(uint64_t amount = 1) {
+    value.fetch_add(amount, std::memory_order_relaxed);
+  }
+  const char* type() const { return "counter"; }
+  void write(std::string& output, const std::string& family,
+             const std::string& labels) const;
+};
+
+class Gauge : public Metric {
+  std::atomic<int64_t> value = 0;
+
+ public:
+  using Metric::Metric;
+  void set(int64_t value) {
+    this->value.store(value, std::memory_order_relaxed);
+  }
+  void add(int64_t amount) {
+    value.fetch_add(amount, std::memory_order_relaxed);
+  }
+  const char* type() const { return "gauge"; }
+  void write(std::string& output, const std::string& family,
+             const std::string& labels) const;
+};
+
+// Milliseconds, e.g. latencies.
+class Histogram : public Metric {
+ public:
+  static constexpr std::array<double, 10> bounds = {1,  2,   5,   10,  25,
+                                                     50, 100, 250, 500, 1000};
+
+ private:
+  // Last is +Inf.
+  std::array<std::atomic<uint64_t>, bounds.size() + 1> buckets{};
+  std::atomic<double> sum = 0;
+
+ public:
+  using Metric::Metric;
+  void observe(double value) {
+    size_t index = std::lower_bound(bounds.begin(), bounds.end(), value) -
+                   bounds.begin();
+    buckets[index].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+  }
+  const char* type() const { return "histogram"; }
+  void write(std::string& output, const std::string& family,
+             const std::string& labels) const;
+};
+
+/*
+  Created on first lookup, same name returns same metric.
+  Family already registered as other type is logged and returned metric isn't listed.
+*/
+Counter& counter(std::string_view name);
+Gauge& gauge(std::string_view name);
+Histogram& histogram(std::string_view name);
+
+// "metrics" command.
+std::string dump();
+}
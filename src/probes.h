@@ -0,0 +1,24 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+/*
+  USDT probes under provider "system_ui". Compiled as single nop, so safe in hot paths, but arguments are evaluated.
+  List: bpftrace -l 'usdt:/usr/lib/libsystem-ui.so:*'
+  e.g. bpftrace -e 'usdt:/usr/lib/libsystem-ui.so:system_ui:request__respond { @[arg1] = count(); }'
+  No-op without <sys/sdt.h> (systemtap-sdt-devel, systemtap-sdt-dev).
+*/
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PROBE(name) DTRACE_PROBE(system_ui, name)
+#define PROBE1(name, a) DTRACE_PROBE1(system_ui, name, a)
+#define PROBE2(name, a, b) DTRACE_PROBE2(system_ui, name, a, b)
+#define PROBE3(name, a, b, c) DTRACE_PROBE3(system_ui, name, a, b, c)
+#else
+#define PROBE(name)
+#define PROBE1(name, a)
+#define PROBE2(name, a, b)
+#define PROBE3(name, a, b, c)
+#endif
@@ -0,0 +1,226 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#include "process.h"
+
+#include <fcntl.h>
+#include <glib.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <map>
+#include <vector>
+
+#include "utils.h"
+
+namespace Process {
+struct Child {
+  std::string command;
+  ExitCallback onExit;
+  OutputCallback onOutput;
+  GIOChannel* output = nullptr;
+  uint outputWatch = 0;
+};
+std::map<pid_t, Child> children;
+
+int signalFd = -1;
+GIOChannel* signalChannel = nullptr;
+uint signalWatch = 0;
+
+void report(pid_t pid, Child& child, int code) {
+  if (child.onExit)
+    child.onExit({pid, code});
+  else if (code != 0)
+    Log::warn("\"" + child.command + "\" exited with " + std::to_string(code) +
+              ".");
+}
+
+void closeOutput(Child& child) {
+  if (child.outputWatch) g_source_remove(child.outputWatch);
+  child.outputWatch = 0;
+  if (child.output) g_io_channel_unref(child.output);
+  child.output = nullptr;
+}
+
+// Only own children, so other waiters like GLib's child watch keep working.
+void reap() {
+  for (auto it = children.begin(); it != children.end();) {
+    int status;
+    pid_t result = waitpid(it->first, &status, WNOHANG);
+    if (result == 0 || (result == -1 && errno == EINTR)) {
+      it++;
+      continue;
+    }
+    int code = 127;
+    if (result > 0)
+      code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    // Remaining output first.
+    if (it->second.output) {
+      char buffer[4096];
+      ssize_t size;
+      int fd = g_io_channel_unix_get_fd(it->second.output);
+      while ((size = read(fd, buffer, sizeof(buffer))) > 0)
+        it->second.onOutput({buffer, (size_t)size});
+      closeOutput(it->second);
+    }
+    Child child = std::move(it->second);
+    pid_t pid = it->first;
+    it = children.erase(it);
+    report(pid, child, code);
+  }
+}
+
+gboolean onSignal(GIOChannel* channel, GIOCondition condition, gpointer data) {
+  // SIGCHLD coalesces, so info is only a wakeup.
+  signalfd_siginfo info;
+  while (read(signalFd, &info, sizeof(info)) == sizeof(info));
+  reap();
+  return G_SOURCE_CONTINUE;
+}
+
+gboolean onOutput(GIOChannel* channel, GIOCondition condition, gpointer data) {
+  pid_t pid = GPOINTER_TO_INT(data);
+  auto it = children.find(pid);
+  if (it == children.end()) return G_SOURCE_REMOVE;
+  char buffer[4096];
+  ssize_t size;
+  int fd = g_io_channel_unix_get_fd(channel);
+  while ((size = read(fd, buffer, sizeof(buffer))) > 0)
+    it->second.onOutput({buffer, (size_t)size});
+  if (size == 0 || (size == -1 && errno != EAGAIN && errno != EINTR)) {
+    // Watch is removed by returning.
+    it->second.outputWatch = 0;
+    closeOutput(it->second);
+    return G_SOURCE_REMOVE;
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+void initialize() {
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGCHLD);
+  pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+  signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (signalFd == -1) return Log::error("signalfd failed.");
+  signalChannel = g_io_channel_unix_new(signalFd);
+  g_io_channel_set_close_on_unref(signalChannel, true);
+  signalWatch = g_io_add_watch(signalChannel, G_IO_IN, onSignal, nullptr);
+  g_source_set_name_by_id(signalWatch, "process exit");
+}
+
+std::vector<Running> running() {
+  std::vector<Running> result;
+  for (const auto& [pid, child] : children)
+    result.push_back({pid, child.command});
+  return result;
+}
+
+void adopt(pid_t pid, const std::string& command) {
+  children[pid] = {.command = command};
+  // May have exited before signalfd existed.
+  reap();
+}
+
+void destroy() {
+  for (auto& [pid, child] : children) closeOutput(child);
+  children.clear();
+  if (signalWatch) g_source_remove(signalWatch);
+  signalWatch = 0;
+  if (signalChannel) g_io_channel_unref(signalChannel);
+  signalChannel = nullptr;
+  signalFd = -1;
+}
+
+// All tokens in one buffer, "argv" points into it. Avoids allocation per token.
+struct Arguments {
+  std::string arena;
+  std::vector<char*> argv;
+
+  Arguments(const std::string& command) {
+    arena.reserve(command.size() + 1);
+    std::vector<size_t> starts;
+    bool inQuotes = false;
+    bool inToken = false;
+    for (char character : command) {
+      if (character == ' ' && !inQuotes) {
+        if (inToken) arena += '\0';
+        inToken = false;
+        continue;
+      }
+      if (!inToken) starts.push_back(arena.size());
+      inToken = true;
+      if (character == '"' || character == '\'')
+        inQuotes = !inQuotes;
+      else
+        arena += character;
+    }
+    arena += '\0';
+    for (size_t start : starts) argv.push_back(arena.data() + start);
+    argv.push_back(nullptr);
+  }
+};
+
+pid_t spawn(const std::string& command, ExitCallback onExit,
+            OutputCallback onOutput) {
+  Arguments arguments(command);
+  auto fail = [&](const std::string& reason) -> pid_t {
+    Log::error(reason + " \"" + command + "\" failed.");
+    // Async like normal exit, so callers handle both the same way.
+    if (onExit) runOnMain([onExit]() { onExit({-1, 127}); });
+    return -1;
+  };
+  if (arguments.argv.size() == 1) return fail("Empty command");
+
+  int pipe[2] = {-1, -1};
+  if (onOutput && pipe2(pipe, O_CLOEXEC) == -1) return fail("pipe2");
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  if (onOutput) posix_spawn_file_actions_adddup2(&actions, pipe[1], 1);
+
+  // Child mustn't inherit blocked SIGCHLD.
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  sigset_t empty, defaults;
+  sigemptyset(&empty);
+  sigemptyset(&defaults);
+  sigaddset(&defaults, SIGCHLD);
+  posix_spawnattr_setsigmask(&attributes, &empty);
+  posix_spawnattr_setsigdefault(&attributes, &defaults);
+  posix_spawnattr_setflags(&attributes,
+                           POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+  pid_t pid;
+  int status = posix_spawnp(&pid, arguments.argv[0], &actions, &attributes,
+                            arguments.argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attributes);
+  if (onOutput) close(pipe[1]);
+  if (status != 0) {
+    if (onOutput) close(pipe[0]);
+    return fail("posix_spawnp");
+  }
+
+  Child& child = children[pid];
+  child.command = command;
+  child.onExit = std::move(onExit);
+  if (onOutput) {
+    child.onOutput = std::move(onOutput);
+    fcntl(pipe[0], F_SETFL, O_NONBLOCK);
+    child.output = g_io_channel_unix_new(pipe[0]);
+    g_io_channel_set_close_on_unref(child.output, true);
+    child.outputWatch =
+        g_io_add_watch(child.output, (GIOCondition)(G_IO_IN | G_IO_HUP),
+                       Process::onOutput, GINT_TO_POINTER(pid));
+    g_source_set_name_by_id(child.outputWatch, "process output");
+  }
+  return pid;
+}
+}
+
+void runNewProcess(const std::string& command) { Process::spawn(command); }
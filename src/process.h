@@ -0,0 +1,44 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+  Spawn supervisor. Children are started with posix_spawnp and reaped through signalfd in main loop,
+  so nothing blocks UI and every exit is reported.
+*/
+namespace Process {
+struct Exit {
+  pid_t pid;
+  // Exit code, or 128 + signal like shells. 127 if it couldn't be started.
+  int code;
+};
+using ExitCallback = std::function<void(const Exit&)>;
+// Stdout chunks as they arrive.
+using OutputCallback = std::function<void(std::string_view)>;
+
+// Blocks SIGCHLD for signalfd. Call before any thread is created, they inherit signal mask.
+void initialize();
+void destroy();
+
+struct Running {
+  pid_t pid;
+  std::string command;
+};
+// Children not exited yet, e.g. handed to next daemon across exec.
+std::vector<Running> running();
+// Supervises child inherited across exec. Its callbacks and output pipe didn't survive, so exit is only logged.
+void adopt(pid_t pid, const std::string& command);
+
+// "command" is split on spaces, quotes group. Without "onExit" failures are logged.
+pid_t spawn(const std::string& command, ExitCallback onExit = nullptr,
+            OutputCallback onOutput = nullptr);
+}
@@ -0,0 +1,144 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#include "scheduler.h"
+
+#include <glib.h>
+
+#include <array>
+#include <map>
+#include <vector>
+
+namespace Scheduler {
+// Hashed timing wheel. Job sits in slot of its deadline tick, later rotations wait in same slot.
+constexpr int64_t tickUs = 4000;
+constexpr size_t slots = 256;
+
+struct Job {
+  int64_t deadline;
+  int64_t latest;
+  uint interval;
+  bool aligned;
+  Callback callback;
+};
+std::map<uint, Job> jobs;
+std::array<std::vector<uint>, slots> wheel;
+uint lastId = 0;
+// Next tick not scanned yet.
+int64_t cursor = g_get_monotonic_time() / tickUs;
+uint timeout = 0;
+int64_t timeoutAt = 0;
+
+void arm();
+
+int64_t alignedDeadline(uint interval, int64_t now) {
+  int64_t intervalUs = interval * 1000ll;
+  int64_t real = g_get_real_time();
+  return now + (intervalUs - real % intervalUs);
+}
+
+void insert(uint id, Job& job) {
+  int64_t tick = std::max(job.deadline / tickUs, cursor);
+  wheel[tick % slots].push_back(id);
+}
+
+gboolean onWake(gpointer) {
+  timeout = 0;
+  int64_t now = g_get_monotonic_time();
+  int64_t nowTick = now / tickUs;
+
+  // Whole wheel at most, e.g. after long idle.
+  std::vector<uint> due;
+  int64_t last = std::min(nowTick, cursor + (int64_t)slots - 1);
+  for (int64_t tick = cursor; tick <= last; tick++) {
+    std::vector<uint>& slot = wheel[tick % slots];
+    std::erase_if(slot, [&](uint id) {
+      auto it = jobs.find(id);
+      if (it == jobs.end()) return true;  // Cancelled.
+      if (it->second.deadline > now) return false;  // Later rotation.
+      due.push_back(id);
+      return true;
+    });
+  }
+  cursor = nowTick + 1;
+  // Jobs beyond scanned ticks but already due, because scan was capped.
+  if (last < nowTick) {
+    for (auto& slot : wheel) {
+      std::erase_if(slot, [&](uint id) {
+        auto it = jobs.find(id);
+        if (it == jobs.end()) return true;
+        if (it->second.deadline > now) return false;
+        due.push_back(id);
+        return true;
+      });
+    }
+  }
+
+  for (uint id : due) {
+    // Earlier callback may have cancelled it.
+    auto it = jobs.find(id);
+    if (it == jobs.end()) continue;
+    Job& job = it->second;
+    Callback callback = job.callback;
+    if (!job.interval)
+      jobs.erase(it);
+    else {
+      int64_t slack = job.latest - job.deadline;
+      // Skips missed ticks instead of bursting.
+      do job.deadline += job.interval * 1000ll;
+      while (job.deadline <= now);
+      if (job.aligned) job.deadline = alignedDeadline(job.interval, now);
+      job.latest = job.deadline + slack;
+      insert(id, job);
+    }
+    callback();
+  }
+  arm();
+  return G_SOURCE_REMOVE;
+}
+
+void arm() {
+  if (jobs.empty()) {
+    if (timeout) g_source_remove(timeout);
+    timeout = 0;
+    return;
+  }
+  int64_t latest = INT64_MAX;
+  for (const auto& [id, job] : jobs) latest = std::min(latest, job.latest);
+  if (timeout && timeoutAt == latest) return;
+  if (timeout) g_source_remove(timeout);
+  timeoutAt = latest;
+  int64_t delay = std::max<int64_t>(0, latest - g_get_monotonic_time());
+  timeout = g_timeout_add((delay + 999) / 1000, onWake, nullptr);
+  g_source_set_name_by_id(timeout, "scheduler");
+}
+
+uint add(uint delay, uint interval, const Callback& callback, uint slack,
+         bool aligned) {
+  int64_t now = g_get_monotonic_time();
+  Job job = {.deadline = aligned ? alignedDeadline(interval, now)
+                                 : now + delay * 1000ll,
+             .interval = interval,
+             .aligned = aligned,
+             .callback = callback};
+  job.latest = job.deadline + slack * 1000ll;
+  uint id = ++lastId;
+  insert(id, jobs[id] = std::move(job));
+  arm();
+  return id;
+}
+
+uint after(uint delay, const Callback& callback, uint slack) {
+  return add(delay, 0, callback, slack, false);
+}
+
+uint every(uint interval, const Callback& callback, uint slack, bool aligned) {
+  return add(interval, interval, callback, slack, aligned);
+}
+
+void cancel(uint id) {
+  // Wheel entry is dropped lazily on scan.
+  if (jobs.erase(id)) arm();
+}
+}
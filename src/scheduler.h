@@ -0,0 +1,27 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+/*
+  Shared timers on one GLib timeout, instead of a timeout per timer.
+  Each job may run anywhere in [deadline, deadline + slack]. Wakeup happens at earliest such latest time,
+  and runs every job whose deadline has passed, so jobs with overlapping windows share one wakeup.
+*/
+namespace Scheduler {
+using Callback = std::function<void()>;
+
+// Runs once after "delay" ms.
+uint after(uint delay, const Callback& callback, uint slack = 0);
+/*
+  Runs every "interval" ms until cancelled.
+  "aligned" puts ticks on wall clock multiples of interval, e.g. clock labels changing exactly on second.
+*/
+uint every(uint interval, const Callback& callback, uint slack = 0,
+           bool aligned = false);
+void cancel(uint id);
+}
@@ -0,0 +1,99 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#include "startup.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "trace.h"
+#include "utils.h"
+
+namespace Startup {
+void run(const std::vector<Stage>& stages) {
+  enum Status { Pending, Running, Done };
+  std::vector<Status> status(stages.size(), Pending);
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<std::thread> workers;
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  auto ms = [](Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
+
+  auto ready = [&](const Stage& stage) {
+    return std::all_of(
+        stage.after.begin(), stage.after.end(), [&](const std::string& name) {
+          for (size_t index = 0; index < stages.size(); index++) {
+            if (stages[index].name == name) return status[index] == Done;
+          }
+          Log::warn("Startup: Unknown stage " + name);
+          return true;
+        });
+  };
+  auto execute = [&](size_t index) {
+    auto begin = Clock::now();
+    {
+      TRACE_SCOPE("startup " + stages[index].name);
+      stages[index].run();
+    }
+    auto end = Clock::now();
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1) << "Startup: "
+        << stages[index].name << " " << ms(end - begin) << "ms (at "
+        << ms(end - start) << "ms)";
+    Log::info(oss.str());
+    {
+      std::lock_guard lock(mutex);
+      status[index] = Done;
+    }
+    changed.notify_all();
+  };
+
+  std::unique_lock lock(mutex);
+  while (true) {
+    bool pending = false;
+    bool running = false;
+    size_t mainStage = stages.size();
+    for (size_t index = 0; index < stages.size(); index++) {
+      if (status[index] != Pending) {
+        running |= status[index] == Running;
+        continue;
+      }
+      pending = true;
+      if (!ready(stages[index])) continue;
+      if (stages[index].main) {
+        if (mainStage == stages.size()) mainStage = index;
+        continue;
+      }
+      status[index] = Running;
+      running = true;
+      workers.emplace_back(execute, index);
+    }
+    if (!pending && !running) break;
+
+    if (mainStage != stages.size()) {
+      status[mainStage] = Running;
+      lock.unlock();
+      execute(mainStage);
+      lock.lock();
+      continue;
+    }
+    if (!running) {
+      Log::error("Startup: Stages depend on each other.");
+      break;
+    }
+    // Nothing runnable here, wait for worker.
+    changed.wait(lock);
+  }
+  lock.unlock();
+  for (auto& worker : workers) worker.join();
+}
+}
@@ -0,0 +1,26 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+  Daemon startup as dependency graph.
+  Stage starts once all stages in "after" are done. Independent worker stages run concurrently on own threads.
+  Anything touching GTK or GLib main context must be "main" stage.
+*/
+namespace Startup {
+struct Stage {
+  std::string name;
+  std::vector<std::string> after;
+  bool main = false;
+  std::function<void()> run;
+};
+
+// Blocks until every stage is done. Logs each stage's time.
+void run(const std::vector<Stage>& stages);
+}
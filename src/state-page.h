@@ -0,0 +1,83 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+/*
+  System state published by daemon in shared memory, for readers polling at any rate without socket round trip.
+  Layout is plain C, bars in other languages can mmap STATE_PAGE_FILE and read it too.
+
+  Seqlock: writer makes "sequence" odd while writing and even after.
+  Reader copies page, and retries if sequence was odd or changed meanwhile. See StatePage::read().
+*/
+#define STATE_PAGE_FILE "/dev/shm/system-ui-state"
+#define STATE_PAGE_VERSION 1
+
+struct StatePage {
+  uint32_t version;
+  std::atomic<uint32_t> sequence;
+
+  struct {
+    uint16_t percent;
+    bool muted;
+    char sink[64];
+  } volume;
+
+  struct {
+    // 0 Playing, 1 Paused, 2 Stopped. Same as PlayerController::Status.
+    uint8_t status;
+    char title[128];
+    char artist[128];
+    // Microseconds. Position was "position" at "positionTime" (CLOCK_MONOTONIC),
+    // so while playing current = position + (now - positionTime).
+    uint64_t duration;
+    uint64_t position;
+    int64_t positionTime;
+  } media;
+
+  struct {
+    // Same as Network::Status.
+    uint8_t status;
+    char label[64];
+  } network;
+
+  struct {
+    // Same as BluetoothController::Status.
+    uint8_t status;
+    uint8_t connected;
+    char device[64];
+  } bluetooth;
+
+  struct {
+    uint8_t cpu;
+    float ramUsedGb;
+    float ramTotalGb;
+  } usage;
+
+  struct {
+    bool lightMode;
+    // 0xRRGGBB.
+    uint32_t primary;
+    uint32_t primarySurface;
+    uint32_t neutral;
+  } theme;
+
+  // Returns false if page is being written for too long, e.g. daemon crashed mid write.
+  bool read(StatePage& copy) const {
+    for (int attempt = 0; attempt < 1000; attempt++) {
+      uint32_t before = sequence.load(std::memory_order_acquire);
+      if (before & 1) continue;
+      std::memcpy((void*)&copy, (const void*)this, sizeof(StatePage));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+  }
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
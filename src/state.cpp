@@ -0,0 +1,344 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#include "state.h"
+
+#include <fcntl.h>
+#include <glib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "components/audio.h"
+#include "state-page.h"
+#include "theme.h"
+#include "utils.h"
+
+namespace State {
+std::unique_ptr<MediaController> media;
+std::vector<std::unique_ptr<PlayerController>> players;
+std::unique_ptr<Network> network;
+std::unique_ptr<BluetoothController> bluetooth;
+Usage usage;
+
+// Player which most recently started playing.
+PlayerController* lastPlaying = nullptr;
+
+StatePage* page = nullptr;
+// Position isn't signaled by players, so queried once per media change.
+uint64_t mediaPosition = 0;
+int64_t mediaPositionTime = 0;
+
+std::map<uint, Listener> listeners;
+uint lastListenerId = 0;
+std::array<std::unique_ptr<Debouncer>, topics.size()> notifiers;
+
+std::string name(Topic topic) {
+  switch (topic) {
+    case Topic::Volume:
+      return "volume";
+    case Topic::Media:
+      return "media";
+    case Topic::Network:
+      return "network";
+    case Topic::Bluetooth:
+      return "bluetooth";
+  }
+  return "";
+}
+
+bool parse(const std::string& value, Topic& topic) {
+  for (Topic it : topics) {
+    if (name(it) == value) {
+      topic = it;
+      return true;
+    }
+  }
+  return false;
+}
+
+void notify(Topic topic) { notifiers[(size_t)topic]->call(); }
+
+PlayerController* activePlayer() {
+  if (lastPlaying && lastPlaying->status == PlayerController::Playing)
+    return lastPlaying;
+  for (const auto& player : players) {
+    if (player->status == PlayerController::Playing) return player.get();
+  }
+  if (lastPlaying) return lastPlaying;
+  return players.empty() ? nullptr : players.front().get();
+}
+
+std::string networkStatus() {
+  switch (network->status) {
+    case Network::Unavailable:
+      return "unavailable";
+    case Network::Disconnected:
+      return "disconnected";
+    case Network::Transient:
+      return "transient";
+    case Network::Connected:
+      return "connected";
+    case Network::ConnectedNoInternet:
+      return "no-internet";
+  }
+  return "";
+}
+
+std::string bluetoothStatus() {
+  switch (bluetooth->status) {
+    case BluetoothController::Unavailable:
+      return "unavailable";
+    case BluetoothController::Blocked:
+      return "blocked";
+    case BluetoothController::Disabled:
+      return "disabled";
+    case BluetoothController::InProgess:
+      return "connecting";
+    case BluetoothController::Enabled:
+      return "enabled";
+  }
+  return "";
+}
+
+Snapshot snapshot(Topic topic) {
+  Snapshot result = {{"topic", name(topic)}};
+  if (topic == Topic::Volume && Audio::defaultSink) {
+    result["volume"] = std::to_string(Audio::defaultSink->volume);
+    result["sink"] = Audio::defaultSink->label;
+  }
+  if (topic == Topic::Media) {
+    if (PlayerController* player = activePlayer()) {
+      constexpr const char* statuses[] = {"playing", "paused", "stopped"};
+      result["status"] = statuses[player->status];
+      result["title"] = player->title;
+      result["artist"] = player->artist;
+      result["artUrl"] = player->artUrl;
+      result["duration"] = std::to_string(player->duration);
+      result["player"] = player->bus;
+    } else
+      result["status"] = "stopped";
+  }
+  if (topic == Topic::Network) {
+    result["status"] = networkStatus();
+    if (!network->ethernet.path.empty())
+      result["ethernet"] = network->ethernet.label;
+  }
+  if (topic == Topic::Bluetooth) {
+    result["status"] = bluetoothStatus();
+    std::string connected;
+    for (const auto& device : bluetooth->devices) {
+      if (device.status != BluetoothDevice::Connected) continue;
+      if (!connected.empty()) connected += ", ";
+      connected += device.label;
+    }
+    result["connected"] = connected;
+  }
+  return result;
+}
+
+std::string toFixed(float value) {
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(1) << value;
+  return oss.str();
+}
+
+std::string age(int64_t time) {
+  return std::to_string((g_get_monotonic_time() - time) / 1000);
+}
+
+bool query(const std::string& name, Snapshot& result, std::string& error) {
+  Topic topic;
+  if (parse(name, topic))
+    result = snapshot(topic);
+  else if (name == "theme") {
+    AppData& data = appData.get();
+    result.insert(data.theme.begin(), data.theme.end());
+    result["mode"] = data.lightMode ? "light" : "dark";
+  } else if (name == "cpu" || name == "ram") {
+    int64_t time = name == "cpu" ? usage.cpuTime : usage.ramTime;
+    if (!time) {
+      error = "No " + name + " sample yet. Expand panel once.";
+      return false;
+    }
+    if (name == "cpu")
+      result["usage"] = std::to_string(usage.cpu);
+    else {
+      result["used"] = toFixed(usage.ramUsedGb);
+      result["total"] = toFixed(usage.ramTotalGb);
+    }
+    // Milliseconds since sampled.
+    result["age"] = age(time);
+  } else {
+    error = "Unknown state '" + name + "'.";
+    return false;
+  }
+  return true;
+}
+
+template <size_t size>
+void copy(char (&target)[size], const std::string& value) {
+  size_t length = std::min(size - 1, value.size());
+  memcpy(target, value.data(), length);
+  target[length] = '\0';
+}
+
+uint32_t rgbFromTheme(const AppData::Theme& theme, const std::string& key) {
+  auto it = theme.find(key);
+  return it == theme.end() ? 0 : argbFromHex(it->second) & 0xFFFFFF;
+}
+
+void openPage() {
+  int file = open(STATE_PAGE_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (file == -1) return Log::error("Unable to open " STATE_PAGE_FILE);
+  if (ftruncate(file, sizeof(StatePage)) == 0) {
+    void* memory = mmap(nullptr, sizeof(StatePage), PROT_READ | PROT_WRITE,
+                        MAP_SHARED, file, 0);
+    if (memory != MAP_FAILED) page = static_cast<StatePage*>(memory);
+  }
+  close(file);
+  if (!page) return Log::error("Unable to map " STATE_PAGE_FILE);
+  memset((void*)page, 0, sizeof(StatePage));
+  page->version = STATE_PAGE_VERSION;
+}
+
+void closePage() {
+  if (!page) return;
+  munmap(page, sizeof(StatePage));
+  page = nullptr;
+  // Missing file tells readers daemon isn't running.
+  unlink(STATE_PAGE_FILE);
+}
+
+void publish() {
+  if (!page) return;
+  uint32_t sequence = page->sequence.load(std::memory_order_relaxed);
+  page->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  page->volume = {};
+  if (Audio::defaultSink) {
+    page->volume.percent = Audio::defaultSink->volume;
+    page->volume.muted = Audio::defaultSink->muted;
+    copy(page->volume.sink, Audio::defaultSink->label);
+  }
+
+  page->media = {.status = PlayerController::Stopped};
+  if (PlayerController* player = activePlayer()) {
+    page->media.status = player->status;
+    copy(page->media.title, player->title);
+    copy(page->media.artist, player->artist);
+    page->media.duration = player->duration;
+    page->media.position = mediaPosition;
+    page->media.positionTime = mediaPositionTime;
+  }
+
+  page->network = {.status = (uint8_t)network->status};
+  copy(page->network.label, network->ethernet.label);
+
+  page->bluetooth = {.status = (uint8_t)bluetooth->status};
+  for (const auto& device : bluetooth->devices) {
+    if (device.status != BluetoothDevice::Connected) continue;
+    if (!page->bluetooth.connected++) copy(page->bluetooth.device, device.label);
+  }
+
+  page->usage = {.cpu = usage.cpu,
+                 .ramUsedGb = usage.ramUsedGb,
+                 .ramTotalGb = usage.ramTotalGb};
+
+  AppData& data = appData.get();
+  page->theme = {.lightMode = data.lightMode,
+                 .primary = rgbFromTheme(data.theme, "primary_40"),
+                 .primarySurface = rgbFromTheme(data.theme, "primary_surface"),
+                 .neutral = rgbFromTheme(data.theme, "neutral_40")};
+
+  page->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+uint subscribe(const Listener& listener) {
+  listeners[++lastListenerId] = listener;
+  return lastListenerId;
+}
+
+void unsubscribe(uint id) { listeners.erase(id); }
+
+void watchPlayer(PlayerController* player) {
+  if (player->status == PlayerController::Playing) lastPlaying = player;
+  player->onChange([player]() {
+    if (player->status == PlayerController::Playing) lastPlaying = player;
+    notify(Topic::Media);
+  });
+}
+
+// Only changed player is (re)loaded, rest keep their state and signal subscription.
+void onPlayersChange(const std::string& bus, bool added) {
+  std::erase_if(players, [&bus](const std::unique_ptr<PlayerController>& player) {
+    if (player->bus != bus) return false;
+    if (lastPlaying == player.get()) lastPlaying = nullptr;
+    return true;
+  });
+  if (added) watchPlayer(players.emplace_back(media->getPlayer(bus)).get());
+  notify(Topic::Media);
+}
+
+void initialize() {
+  for (Topic topic : topics) {
+    notifiers[(size_t)topic] = std::make_unique<Debouncer>(16, [topic]() {
+      // Copy, listener may unsubscribe itself.
+      auto current = listeners;
+      for (const auto& [id, listener] : current) {
+        if (listeners.contains(id)) listener(topic);
+      }
+    });
+  }
+
+  // Audio::initialize() is done by daemon startup, off main thread.
+  Audio::onChange([]() { notify(Topic::Volume); });
+
+  media = std::make_unique<MediaController>();
+  media->onPlayersChange(onPlayersChange);
+  players = media->getPlayers();
+  for (const auto& player : players) watchPlayer(player.get());
+
+  network = std::make_unique<Network>();
+  network->onChange([]() { notify(Topic::Network); });
+
+  bluetooth = std::make_unique<BluetoothController>();
+  bluetooth->onChange([]() { notify(Topic::Bluetooth); });
+
+  openPage();
+  subscribe([](Topic topic) {
+    publish();
+    if (topic != Topic::Media) return;
+    PlayerController* player = activePlayer();
+    if (!player) {
+      mediaPosition = 0;
+      mediaPositionTime = g_get_monotonic_time();
+      return publish();
+    }
+    // Async, slow or hung player mustn't stall main loop.
+    player->position([](uint64_t position) {
+      mediaPosition = position;
+      mediaPositionTime = g_get_monotonic_time();
+      publish();
+    });
+  });
+  publish();
+}
+
+void destroy() {
+  closePage();
+  listeners.clear();
+  lastPlaying = nullptr;
+  players.clear();
+  media.reset();
+  network.reset();
+  bluetooth.reset();
+  Audio::destroy();
+  for (auto& notifier : notifiers) notifier.reset();
+}
+}
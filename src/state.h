@@ -0,0 +1,66 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "components/bluetooth.h"
+#include "components/media.h"
+#include "components/network.h"
+
+/*
+  Daemon owned, long lived system state.
+  Independent of extensions, so scripts can observe it even when panel is closed.
+*/
+namespace State {
+enum class Topic : uint8_t { Volume, Media, Network, Bluetooth };
+constexpr std::array<Topic, 4> topics = {Topic::Volume, Topic::Media,
+                                         Topic::Network, Topic::Bluetooth};
+std::string name(Topic topic);
+bool parse(const std::string& value, Topic& topic);
+
+extern std::unique_ptr<MediaController> media;
+extern std::vector<std::unique_ptr<PlayerController>> players;
+extern std::unique_ptr<Network> network;
+extern std::unique_ptr<BluetoothController> bluetooth;
+
+// Playing player, otherwise the one last played.
+PlayerController* activePlayer();
+
+using Snapshot = std::map<std::string, std::string>;
+Snapshot snapshot(Topic topic);
+
+// Latest panel tile samples. Daemon doesn't read /proc for queries.
+struct Usage {
+  uint8_t cpu = 0;
+  float ramUsedGb = 0;
+  float ramTotalGb = 0;
+  // g_get_monotonic_time(), 0 if never sampled.
+  int64_t cpuTime = 0;
+  int64_t ramTime = 0;
+};
+extern Usage usage;
+
+// Writes state page, see state-page.h. Topic changes are published automatically.
+void publish();
+
+// "get" command, e.g. "get volume". Only reads memory.
+bool query(const std::string& name, Snapshot& result, std::string& error);
+
+/*
+  Called at most once per frame per topic, however many component changes happened.
+  Safe to unsubscribe inside listener.
+*/
+using Listener = std::function<void(Topic)>;
+uint subscribe(const Listener& listener);
+void unsubscribe(uint id);
+
+void initialize();
+void destroy();
+}
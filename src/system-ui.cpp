@@ -4,6 +4,7 @@
 
 #include <iostream>
 
+#include "actions/bench.h"
 #include "actions/patch.h"
 #include "components/media.h"
 #include "daemon.h"
@@ -17,6 +18,8 @@ void usage() {
       {"", "panel|launcher", "Buit-in extensions."},
       {"", "{file}", "Extensions directory \".so\" files."},
       {""},
+      {"reload", "daemon", "Restart new binary, keeping state."},
+      {""},
       {"media", "", "MPRIS controls."},
       {"", "next"},
       {"", "previous"},
@@ -37,6 +40,32 @@ void usage() {
       {""},
       {"patch", "./template ./target", "Find & replace variables."},
       {""},
+      {"get", "", "Print current state as JSON."},
+      {"", "volume|media|network|bluetooth", ""},
+      {"", "theme|cpu|ram", ""},
+      {""},
+      {"logs", "[count]", "Recent daemon logs. Default 50."},
+      {"metrics", "", "Daemon metrics in Prometheus text format."},
+      {""},
+      {"trace", "start", "Record spans. Needs xmake f --tracing=y."},
+      {"", "stop [file]", "Write Chrome trace JSON."},
+      {""},
+      {"stats", "", "Print daemon statistics as JSON."},
+      {"", "launch", "App launch to first window latency."},
+      {"", "memory", "RSS/PSS and memory held per subsystem."},
+      {""},
+      {"watch", "", "Print state changes as JSON lines."},
+      {"", "volume|media|network|bluetooth", "Topics. Default all."},
+      {""},
+      {"bench", "ipc", "Daemon round trip latency."},
+      {"", "--clients 8", "Concurrent connections."},
+      {"", "--requests 1000", "Per client."},
+      {"", "--mix \"ping,theme 67abe8\"", "Commands cycled by each client."},
+      {""},
+      {"{command} \\;", "{command}", "Batch in one request."},
+      {"-", "", "Read commands from stdin over one connection."},
+      {"--json", "{command}", "Print raw daemon response."},
+      {""},
       {"Daemon Logs:", "", LOG_FILE},
       {"App Data:", "", APP_DATA_FILE},
       {"Icons:", "", THEMED_ICONS},
@@ -78,6 +107,13 @@ int main(int argc, char* argv[]) {
     return 0;
   }
 
+  Ipc::Client client;
+  if (std::string(argv[1]) == "--json") {
+    client.format = Ipc::Format::Json;
+    argv++;
+    argc--;
+  }
+
   std::string command;
   std::vector<std::string> args;
   for (int i = 1; i < argc; i++) {
@@ -85,6 +121,10 @@ int main(int argc, char* argv[]) {
     command += argv[i];
     args.push_back(argv[i]);
   }
+  if (args.empty()) {
+    usage();
+    return 0;
+  }
 
   if (args[0] == "patch") {
     if (args.size() != 3) {
@@ -101,31 +141,94 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  if (args[0] == "bench") {
+    std::string error;
+    bench(args, error);
+    if (error.empty()) return 0;
+    Log::error(error);
+    return 1;
+  }
+
   if (args[0] == "media") {
-    MediaController media;
-    auto players = media.getPlayers();
-    if (players.empty()) {
-      Log::error("No active player found.");
+    std::string error;
+    // Daemon already knows active player. Otherwise query D-Bus directly.
+    if (!client.connect(error)) {
+      MediaController media;
+      auto players = media.getPlayers();
+      if (players.empty()) {
+        Log::error("No active player found.");
+        return 1;
+      }
+      auto it = std::find_if(
+          players.begin(), players.end(),
+          [](const std::unique_ptr<PlayerController>& player) {
+            return player->status == PlayerController::Playing;
+          });
+      PlayerController& player = it == players.end() ? *players.front() : **it;
+      mediaAction(player, args, error);
+      if (error.empty()) return 0;
+      Log::error(error);
       return 1;
-    } else {
-      std::unique_ptr<PlayerController>& player = players.front();
-      if (args[1] == "play-pause") player->playPause();
-      if (args[1] == "next") player->next();
-      if (args[1] == "previous") player->previous();
-      if (args[1] == "progress") player->progress(std::stoi(args[2]));
-      return 0;
     }
   }
 
-  Daemon::Response response = Daemon::request(command);
+  if (command == "-") {
+    // Keeps single daemon connection. Prints one JSON response per line.
+    std::string line;
+    std::string buffer;
+    while (std::getline(std::cin, line)) {
+      std::vector<std::string> lineArgs;
+      std::stringstream ss(line);
+      std::string arg;
+      while (ss >> arg) lineArgs.push_back(arg);
+      if (lineArgs.empty()) continue;
+
+      Daemon::Response response = client.request(lineArgs);
+      glz::write_json(response, buffer);
+      std::cout << buffer << std::endl;
+      if (!client.connected()) return 1;
+    }
+    return 0;
+  }
+
+  if (args[0] == "watch") {
+    Daemon::Response response = client.request(args);
+    if (!response.error.empty()) {
+      Log::error(response.error);
+      return 1;
+    }
+    std::string buffer;
+    while (client.receive(response)) {
+      glz::write_json(response.data, buffer);
+      std::cout << buffer << std::endl;
+    }
+    return 0;
+  }
+
+  // Re-executed by "reload daemon". Socket is inherited, nobody to ask.
+  if (command == "run daemon" && Daemon::reloaded()) {
+    Daemon::initialize();
+    return 0;
+  }
+
+  Daemon::Response response = client.request(args);
+  if (client.format == Ipc::Format::Json && client.connected()) {
+    std::cout << client.buffer << std::endl;
+    return response.code;
+  }
 
   if (response.error.empty()) {
     if (!response.info.empty()) Log::info(response.info);
+    if (!response.data.empty()) {
+      std::string buffer;
+      glz::write_json(response.data, buffer);
+      std::cout << buffer << std::endl;
+    }
   } else {
     if (command == "run daemon") {
       Log::info("Daemon running.");
       Daemon::initialize();
-    } else if (command == "exit daemon") {
+    } else if (command == "exit daemon" || command == "reload daemon") {
       Log::error("Daemon hasn't been started.");
       return 1;
     } else {
@@ -5,9 +5,15 @@
 #include "theme.h"
 
 #include <filesystem>
+#include <optional>
 
 #include "daemon.h"
 #include "extension.h"
+#include "memory.h"
+#include "metrics.h"
+#include "probes.h"
+#include "state.h"
+#include "trace.h"
 
 using material_color_utilities::Hct;
 
@@ -55,6 +61,7 @@ Rgb rgbFromHex(const std::string &hex) {
 
 namespace Theme {
 GtkCssProvider *cssProvider = nullptr;
+Memory::Account<Memory::Tag::Css> cssMemory;
 std::string defaultColor = "#00639b";
 
 constexpr int lightThemeMaxLightness = 98;
@@ -64,13 +71,12 @@ int inverseTone(int tone) {
                   lightThemeMaxLightness);
 }
 
-AppData::Theme fromColor(const std::string &hex) {
+AppData::Theme fromColor(const std::string &hex, bool lightMode) {
   AppData::Theme palette = {{"primary", hex}};
   Hct primary(argbFromHex(hex));
   palette["neutral"] = hexFromHct(primary.get_hue(), 10, primary.get_tone());
 
   AppData::Theme theme;
-  bool lightMode = appData.get().lightMode;
   for (const auto &[key, value] : palette) {
     Hct hct(argbFromHex(value));
 
@@ -95,7 +101,7 @@ AppData::Theme fromColor(const std::string &hex) {
   return theme;
 }
 
-AppData::Theme fromImage(cairo_surface_t *surface) {
+AppData::Theme fromImage(cairo_surface_t *surface, bool lightMode) {
   int width = cairo_image_surface_get_width(surface);
   int height = cairo_image_surface_get_height(surface);
   std::vector<uint32_t> pixels(width * height);
@@ -112,7 +118,7 @@ AppData::Theme fromImage(cairo_surface_t *surface) {
   std::vector<uint32_t> colors = material_color_utilities::RankedSuggestions(
       result.color_to_count,
       {.desired = 1, .fallback_color_argb = (int)argbFromHex(defaultColor)});
-  return fromColor(hexFromArgb(colors[0]));
+  return fromColor(hexFromArgb(colors[0]), lightMode);
 }
 
 cairo_surface_t *resize(cairo_surface_t *source, uint16_t width,
@@ -138,6 +144,9 @@ float luminance(unsigned char *pixel) {
 constexpr uint8_t iconSize = 64;
 std::tuple<std::filesystem::path, AppData::Theme> createIcon(
     const std::string &name) {
+  TRACE_SCOPE("createIcon " + name);
+  static Metrics::Counter &icons = Metrics::counter("icons_created_total");
+  icons.add();
   GError *error = nullptr;
   // This is internal pixbuf. Don't modify directly.
   GdkPixbuf *pixbuf =
@@ -228,15 +237,33 @@ std::tuple<std::filesystem::path, AppData::Theme> createIcon(
 }
 
 void generate(const std::string &color) {
-  appData.get().theme = fromColor(color.empty() ? defaultColor : color);
+  TRACE_SCOPE("Theme::generate");
+  AppData &data = appData.get();
+  data.color = color.empty() ? defaultColor : color;
+  data.theme = fromColor(data.color, data.lightMode);
   appData.save();
   for (const auto &it : Extensions::manager->extensions)
     it.second->onThemeChange();
 }
 
+std::optional<std::string> preloadedCss;
+
+std::string readCss() {
+  std::stringstream css;
+  for (const std::string &path : {DEFAULT_CSS, USER_CSS}) {
+    std::ifstream file(path);
+    if (file.is_open()) css << file.rdbuf();
+  }
+  return css.str();
+}
+
+void preload() { preloadedCss = readCss(); }
+
 void apply(const std::string &color) {
+  TRACE_SCOPE("Theme::apply");
+  PROBE1(theme__apply, color.c_str());
   AppData &data = appData.get();
-  if (data.theme["primary_40"].empty() || !color.empty()) generate(color);
+  if (!data.theme.contains("primary_40") || !color.empty()) generate(color);
 
   std::string colorsCss;
   for (const auto &[key, value] : data.theme)
@@ -248,16 +275,8 @@ void apply(const std::string &color) {
     colorsCss +=
         "@define-color primary_surface_0 mix(#000, @primary_80, 0.1);\n";
 
-  std::stringstream defaultCss;
-  {
-    std::ifstream file(DEFAULT_CSS);
-    if (file.is_open()) defaultCss << file.rdbuf();
-  }
-  std::stringstream userCss;
-  {
-    std::ifstream file(USER_CSS);
-    if (file.is_open()) userCss << file.rdbuf();
-  }
+  std::string css = preloadedCss ? std::move(*preloadedCss) : readCss();
+  preloadedCss.reset();
 
   if (cssProvider)
     gtk_style_context_remove_provider_for_screen(
@@ -266,8 +285,7 @@ void apply(const std::string &color) {
     cssProvider = gtk_css_provider_new();
   GError *error = nullptr;
   gtk_css_provider_load_from_data(
-      cssProvider, (colorsCss + defaultCss.str() + userCss.str()).c_str(), -1,
-      &error);
+      cssProvider, (colorsCss + css).c_str(), -1, &error);
   if (error) {
     Log::error("Invalid CSS: " + std::string(error->message));
     g_error_free(error);
@@ -277,10 +295,15 @@ void apply(const std::string &color) {
   gtk_style_context_add_provider_for_screen(
       gdk_screen_get_default(), (GtkStyleProvider *)cssProvider,
       GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+  cssMemory.set(1, colorsCss.size() + css.size());
+  static Metrics::Counter &reloads = Metrics::counter("css_reloads_total");
+  reloads.add();
+  State::publish();
 }
 
 void destroy() {
   g_object_unref(cssProvider);
   cssProvider = nullptr;
+  cssMemory.set(0, 0);
 }
 }
\ No newline at end of file
@@ -24,8 +24,9 @@ Rgb rgbFromHex(const std::string& hex);
 
 namespace Theme {
 extern std::string defaultColor;
-AppData::Theme fromColor(const std::string& hex);
-AppData::Theme fromImage(cairo_surface_t* surface);
+// Pure, safe on worker. Caller reads "lightMode" from app data on main thread.
+AppData::Theme fromColor(const std::string& hex, bool lightMode);
+AppData::Theme fromImage(cairo_surface_t* surface, bool lightMode);
 
 cairo_surface_t* resize(cairo_surface_t* source, uint16_t width,
                         uint16_t height, uint16_t newWidth = 24);
@@ -33,6 +34,8 @@ cairo_surface_t* resize(cairo_surface_t* source, uint16_t width,
 std::tuple<std::filesystem::path, AppData::Theme> createIcon(
     const std::string& name);
 
+// Reads CSS files for next apply(). Safe off main thread.
+void preload();
 void apply(const std::string& color = "");
 void destroy();
 }
\ No newline at end of file
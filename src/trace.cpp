@@ -0,0 +1,100 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#include "trace.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "utils.h"
+
+namespace Trace {
+// Chrome "complete" event, see Trace Event Format.
+struct Event {
+  std::string name;
+  std::string ph = "X";
+  int64_t ts;
+  int64_t dur;
+  int pid;
+  int tid;
+};
+struct File {
+  std::vector<Event> traceEvents;
+  std::string displayTimeUnit = "ms";
+};
+
+// Bounds memory if never stopped.
+constexpr size_t maxEvents = 200000;
+
+std::atomic<bool> recording = enabled;
+std::mutex mutex;
+std::vector<Event> events;
+size_t dropped = 0;
+
+int64_t now() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void add(std::string&& name, int64_t begin) {
+  thread_local int tid = gettid();
+  int64_t end = now();
+  std::lock_guard lock(mutex);
+  if (events.size() >= maxEvents) {
+    dropped++;
+    return;
+  }
+  events.push_back({.name = std::move(name),
+                    .ts = begin,
+                    .dur = end - begin,
+                    .pid = getpid(),
+                    .tid = tid});
+}
+
+void record(std::string_view name, int64_t begin) {
+  if (recording.load(std::memory_order_relaxed)) add(std::string(name), begin);
+}
+
+void start() {
+  std::lock_guard lock(mutex);
+  events.clear();
+  dropped = 0;
+  recording = true;
+}
+
+bool stop(const std::string& file, std::string& error) {
+  File content;
+  {
+    std::lock_guard lock(mutex);
+    recording = false;
+    content.traceEvents.swap(events);
+    if (dropped) Log::warn(std::to_string(dropped) + " trace spans dropped.");
+  }
+  std::string buffer;
+  glz::write_json(content, buffer);
+  prepareDirectory(file);
+  std::ofstream stream(file, std::ios::trunc);
+  stream << buffer;
+  if (!stream.flush()) {
+    error = "Unable to write " + file;
+    return false;
+  }
+  return true;
+}
+
+Scope::Scope(std::string_view name) : begin(-1) {
+  if (!recording.load(std::memory_order_relaxed)) return;
+  this->name = name;
+  begin = now();
+}
+
+Scope::~Scope() {
+  if (begin >= 0) add(std::move(name), begin);
+}
+}
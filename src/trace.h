@@ -0,0 +1,52 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+  Span tracing, exported as Chrome trace JSON for chrome://tracing or ui.perfetto.dev.
+  Spans compile out unless built with "xmake f --tracing=y".
+  Tracing build records from daemon start, so startup is included. "system-ui trace start|stop" picks window.
+*/
+#ifdef TRACING
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+// Span from here to end of enclosing block.
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
+
+namespace Trace {
+constexpr bool enabled =
+#ifdef TRACING
+    true;
+#else
+    false;
+#endif
+
+// Microseconds, monotonic.
+int64_t now();
+// Span started at "begin" ending now, for spans not fitting one block e.g. transitions.
+void record(std::string_view name, int64_t begin);
+
+// Discards recorded spans and starts again.
+void start();
+// Writes spans recorded since start() to "file" and stops recording.
+bool stop(const std::string& file, std::string& error);
+
+class Scope {
+  std::string name;
+  // -1 while not recording.
+  int64_t begin;
+
+ public:
+  Scope(std::string_view name);
+  ~Scope();
+};
+}
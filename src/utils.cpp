@@ -5,12 +5,15 @@
 #include "utils.h"
 
 #include <glib.h>
-#include <spawn.h>
 
-#include <csignal>
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 
+#include "scheduler.h"
+
 #ifdef DEV
 const std::string SHARE_DIR =
     std::filesystem::current_path().string() + "/assets";
@@ -20,8 +23,10 @@ const std::string SHARE_DIR = "/usr/share/system-ui";
 const std::string HOME = std::getenv("HOME");
 const std::string SOCKET_FILE = "/tmp/system-ui/daemon.sock";
 const std::string LOG_FILE = "/tmp/system-ui/daemon.log";
+const std::string TRACE_FILE = "/tmp/system-ui/trace.json";
 const std::string CONFIG_DIR = HOME + "/.config/system-ui";
 const std::string APP_DATA_FILE = CONFIG_DIR + "/app-data.json";
+const std::string APP_DATA_CACHE = HOME + "/.cache/system-ui/app-data.beve";
 const std::string USER_CONFIG = CONFIG_DIR + "/system-ui.json";
 const std::string EXTENSIONS_DIR = CONFIG_DIR + "/extensions";
 const std::string USER_CSS = CONFIG_DIR + "system-ui.css";
@@ -29,51 +34,213 @@ const std::string DEFAULT_CSS = SHARE_DIR + "/system-ui.css";
 const std::string THEMED_ICONS = HOME + "/.cache/system-ui/icons";
 
 namespace Log {
-std::string type;
-std::string color;
-bool inFile = false;
+constexpr size_t maxFileSize = 1024 * 1024;
+constexpr size_t ringSize = 512;
+
+struct Node {
+  std::atomic<Node*> next = nullptr;
+  Record record;
+};
+
+// Vyukov MPSC queue. Producers only exchange "head", writer owns "tail".
+Node stub;
+std::atomic<Node*> head = &stub;
+Node* tail = &stub;
+
+std::atomic<bool> running = false;
+bool toFile = false;
+std::thread writer;
+// Changed on every push, writer sleeps on it.
+std::atomic<uint32_t> signal = 0;
+std::atomic<bool> sleeping = false;
+// Writer's file, drained by stop() and late writes once writer exits.
+std::ofstream file;
+size_t fileSize = 0;
+// Set after writer's last drain, guarded by "stopMutex".
+std::mutex stopMutex;
+bool stopped = false;
+
+std::mutex ringMutex;
+std::vector<Record> ring;
+size_t ringNext = 0;
+
+const char* name(Level level) {
+  switch (level) {
+    case Level::Info:
+      return "info";
+    case Level::Warn:
+      return "warn";
+    case Level::Error:
+      return "error";
+  }
+  return "";
+}
+
+const char* color(Level level) {
+  switch (level) {
+    case Level::Info:
+      return blue;
+    case Level::Warn:
+      return yellow;
+    case Level::Error:
+      return red;
+  }
+  return colorOff;
+}
+
+std::string format(const Record& record) {
+  std::tm local;
+  localtime_r(&record.time, &local);
+  char time[16];
+  std::strftime(time, sizeof(time), "%I:%M:%S", &local);
+  return std::string(time) + " " + name(record.level) + ": " + record.file +
+         ":" + std::to_string(record.line) + ": " + record.message;
+}
+
+void print(const Record& record) {
+  std::cout << color(record.level) << name(record.level) << ": ";
+  if (record.level != Level::Info) std::cout << gray << record.file << ": ";
+  std::cout << colorOff << record.message << std::endl;
+}
 
-std::string getTime() {
-  std::time_t now;
-  std::time(&now);
-  char time[80];
-  std::strftime(time, sizeof(time), "%I:%M", std::localtime(&now));
-  return time;
+Node* pop() {
+  Node* next = tail->next.load(std::memory_order_acquire);
+  if (tail == &stub) {
+    if (!next) return nullptr;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next) {
+    Node* node = tail;
+    tail = next;
+    return node;
+  }
+  // Last node. Re-insert stub so it can be detached, unless producer is mid push.
+  if (tail != head.load(std::memory_order_acquire)) return nullptr;
+  stub.next.store(nullptr, std::memory_order_relaxed);
+  Node* previous = head.exchange(&stub, std::memory_order_acq_rel);
+  previous->next.store(&stub, std::memory_order_release);
+  next = tail->next.load(std::memory_order_acquire);
+  if (!next) return nullptr;
+  Node* node = tail;
+  tail = next;
+  return node;
+}
+
+void push(Node* node) {
+  Node* previous = head.exchange(node, std::memory_order_acq_rel);
+  previous->next.store(node, std::memory_order_release);
 }
 
-void print(const std::string& message, const std::source_location& location) {
-  std::string filename =
-      std::filesystem::path(location.file_name()).filename().string() + ": ";
-  if (inFile) {
-    std::ofstream file(LOG_FILE, std::ios::app);
-    file << getTime() + " " + type + ": " + filename + message << std::endl;
-  } else {
-    std::cout << color << type << ": ";
-    if (type != "info") std::cout << gray << filename;
-    std::cout << colorOff << message << std::endl;
+void drain() {
+  bool written = false;
+  while (Node* node = pop()) {
+    Record& record = node->record;
+    if (toFile) {
+      // Rotation keeps one previous file.
+      if (file.is_open() && fileSize > maxFileSize) {
+        file.close();
+        std::error_code error;
+        std::filesystem::rename(LOG_FILE, LOG_FILE + ".1", error);
+      }
+      if (!file.is_open()) {
+        file.open(LOG_FILE, std::ios::app);
+        std::error_code error;
+        fileSize = std::filesystem::file_size(LOG_FILE, error);
+        if (error) fileSize = 0;
+      }
+      std::string line = format(record) + '\n';
+      file << line;
+      fileSize += line.size();
+      written = true;
+    } else
+      print(record);
+
+    std::lock_guard lock(ringMutex);
+    if (ring.size() < ringSize)
+      ring.push_back(std::move(record));
+    else
+      ring[ringNext] = std::move(record);
+    ringNext = (ringNext + 1) % ringSize;
+    delete node;
   }
+  if (written) file.flush();
 }
 
-void info(const std::string& message, const std::source_location& location) {
-  color = blue;
-  type = "info";
-  print(message, location);
+void loop() {
+  while (true) {
+    uint32_t current = signal.load();
+    drain();
+    if (!running.load()) {
+      drain();
+      break;
+    }
+    // Producers only notify while sleeping, see write().
+    sleeping.store(true);
+    if (signal.load() == current) signal.wait(current);
+    sleeping.store(false);
+  }
 }
 
-void error(const std::string& message, const std::source_location& location) {
-  color = red;
-  type = "error";
-  print(message, location);
+void start(bool file) {
+  if (running) return;
+  {
+    std::lock_guard lock(stopMutex);
+    stopped = false;
+  }
+  toFile = file;
+  running = true;
+  writer = std::thread(loop);
 }
 
-void warn(const std::string& message, const std::source_location& location) {
-  color = yellow;
-  type = "warn";
-  print(message, location);
+void stop() {
+  if (!running) return;
+  running = false;
+  signal.fetch_add(1);
+  signal.notify_one();
+  writer.join();
+  // Records pushed while writer was exiting.
+  std::lock_guard lock(stopMutex);
+  drain();
+  stopped = true;
+}
+
+std::vector<Record> recent(size_t count) {
+  std::lock_guard lock(ringMutex);
+  count = std::min(count, ring.size());
+  std::vector<Record> result;
+  result.reserve(count);
+  size_t oldest = ring.size() < ringSize ? 0 : ringNext;
+  for (size_t index = ring.size() - count; index < ring.size(); index++)
+    result.push_back(ring[(oldest + index) % ring.size()]);
+  return result;
+}
+
+void write(Level level, std::string&& message,
+           const std::source_location& location) {
+  const char* file = std::strrchr(location.file_name(), '/');
+  Record record = {.level = level,
+                   .time = std::time(nullptr),
+                   .file = file ? file + 1 : location.file_name(),
+                   .line = location.line(),
+                   .message = std::move(message)};
+  // Stdout is closed in backgrounded daemon, so file logging continues after stop.
+  if (!running && !toFile) return print(record);
+
+  push(new Node{.record = std::move(record)});
+  if (!running.load()) {
+    // Writer is gone or about to be. Before stop() drained, its drain picks this up.
+    std::lock_guard lock(stopMutex);
+    if (stopped) drain();
+    return;
+  }
+  signal.fetch_add(1);
+  if (sleeping.load()) signal.notify_one();
 }
 }
 
-StorageManager<AppData> appData = StorageManager<AppData>(APP_DATA_FILE);
+StorageManager<AppData> appData =
+    StorageManager<AppData>(APP_DATA_FILE, APP_DATA_CACHE);
 StorageManager<UserConfig> userConfig = StorageManager<UserConfig>(USER_CONFIG);
 
 void prepareDirectory(const std::string& path) {
@@ -104,49 +271,143 @@ std::string run(const std::string& command) {
   return result;
 }
 
-void runNewProcess(const std::string& command) {
-  std::vector<char*> args;
-  std::string arg;
-  bool inQuotes = false;
-  for (int i = 0; i < command.length(); i++) {
-    auto character = command[i];
-    if ((character == ' ' && !inQuotes)) {
-      args.emplace_back(strdup(arg.c_str()));
-      arg.clear();
-    } else if (character == '"' || character == '\'')
-      inQuotes = !inQuotes;
-    else
-      arg += character;
+Debouncer::Debouncer(uint ms, const std::function<void()>& callback,
+                     Mode mode)
+    : ms(ms), callback(callback), mode(mode) {}
+
+Debouncer::~Debouncer() { cancel(); }
+
+bool Debouncer::pending() { return job > 0; }
+
+void Debouncer::cancel() {
+  if (job > 0) Scheduler::cancel(job);
+  job = 0;
+}
+
+void Debouncer::call() {
+  // e.g. PipeWire thread. Scheduler is main thread only.
+  if (!isMainThread())
+    return runOnMain([this, alive = std::weak_ptr<bool>(alive)]() {
+      if (alive.lock()) call();
+    });
+
+  if (mode == Debounce)
+    cancel();
+  else if (job > 0)
+    return;
+
+  if (mode == Leading) {
+    job = Scheduler::after(ms, [this]() { job = 0; }, ms / 10);
+    callback();
+    return;
+  }
+  job = Scheduler::after(
+      ms,
+      [this]() {
+        job = 0;
+        callback();
+      },
+      ms / 10);
+}
+
+thread_local int currentWorker = -1;
+
+ThreadPool::ThreadPool(size_t size) {
+  for (size_t index = 0; index < size; index++)
+    queues.push_back(std::make_unique<Queue>());
+  for (size_t index = 0; index < size; index++)
+    threads.emplace_back(&ThreadPool::loop, this, index);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
   }
-  if (!arg.empty()) args.emplace_back(strdup(arg.c_str()));
-  args.emplace_back(nullptr);
+  wake.notify_all();
+  for (auto& thread : threads) thread.join();
+}
 
-  // todo: Display standard error dialog. Errors like "xdg-open /path/nonexistent"
-  std::signal(SIGCHLD, SIG_IGN);
-  pid_t pid;
-  int status =
-      posix_spawnp(&pid, args[0], nullptr, nullptr, args.data(), environ);
-  if (status != 0) Log::error("posix_spawnp \"" + command + "\" failed.");
+void ThreadPool::post(Job&& job) {
+  size_t worker = currentWorker >= 0 ? currentWorker
+                                     : next.fetch_add(1) % queues.size();
+  {
+    std::lock_guard lock(queues[worker]->mutex);
+    queues[worker]->jobs.push_back(std::move(job));
+  }
+  {
+    std::lock_guard lock(mutex);
+    pending++;
+  }
+  wake.notify_one();
+}
 
-  for (char* arg : args) free(arg);
+bool ThreadPool::take(size_t worker, Job& job) {
+  {
+    Queue& own = *queues[worker];
+    std::lock_guard lock(own.mutex);
+    if (!own.jobs.empty()) {
+      job = std::move(own.jobs.back());
+      own.jobs.pop_back();
+      return true;
+    }
+  }
+  for (size_t offset = 1; offset < queues.size(); offset++) {
+    Queue& other = *queues[(worker + offset) % queues.size()];
+    std::lock_guard lock(other.mutex);
+    if (!other.jobs.empty()) {
+      job = std::move(other.jobs.front());
+      other.jobs.pop_front();
+      return true;
+    }
+  }
+  return false;
 }
 
-Debouncer::Debouncer(uint ms, const std::function<void()>& callback)
-    : ms(ms), callback(callback) {}
+void ThreadPool::loop(size_t worker) {
+  currentWorker = worker;
+  while (true) {
+    {
+      std::unique_lock lock(mutex);
+      wake.wait(lock, [this]() { return stopping || pending > 0; });
+      if (stopping) return;
+      pending--;
+    }
+    // Every "pending" count has a queued job, though maybe in another queue.
+    Job job;
+    while (!take(worker, job)) std::this_thread::yield();
+    job();
+  }
+}
 
-Debouncer::~Debouncer() {
-  if (interval > 0) g_source_remove(interval);
+ThreadPool& workers() {
+  static ThreadPool pool;
+  return pool;
 }
 
-void Debouncer::call() {
-  if (interval > 0) return;
-  interval = g_timeout_add(
-      ms,
-      [](gpointer data) -> gboolean {
-        Debouncer* _this = static_cast<Debouncer*>(data);
-        _this->callback();
-        _this->interval = 0;
+namespace {
+// Static initialization runs on main thread. Fork keeps calling thread's id.
+const std::thread::id mainThread = std::this_thread::get_id();
+std::mutex mainMutex;
+std::vector<std::function<void()>> mainCallbacks;
+}
+
+void runOnMain(std::function<void()>&& callback) {
+  std::lock_guard lock(mainMutex);
+  mainCallbacks.push_back(std::move(callback));
+  if (mainCallbacks.size() > 1) return;  // Dispatch already scheduled.
+  uint idle = g_idle_add(
+      [](gpointer) -> gboolean {
+        std::vector<std::function<void()>> callbacks;
+        {
+          std::lock_guard lock(mainMutex);
+          callbacks.swap(mainCallbacks);
+        }
+        for (auto& callback : callbacks) callback();
         return G_SOURCE_REMOVE;
       },
-      this);
+      nullptr);
+  g_source_set_name_by_id(idle, "runOnMain");
 }
+
+bool isMainThread() { return std::this_thread::get_id() == mainThread; }
@@ -4,25 +4,43 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
 #include <source_location>
+#include <thread>
+#include <type_traits>
 
+#include "glaze/beve.hpp"
 #include "glaze/json.hpp"
 
 extern const std::string SHARE_DIR;
 extern const std::string HOME;
 extern const std::string SOCKET_FILE;
 extern const std::string LOG_FILE;
+extern const std::string TRACE_FILE;
 extern const std::string CONFIG_DIR;
 extern const std::string APP_DATA_FILE;
+extern const std::string APP_DATA_CACHE;
 extern const std::string USER_CONFIG;
 extern const std::string EXTENSIONS_DIR;
 extern const std::string USER_CSS;
 extern const std::string DEFAULT_CSS;
 extern const std::string THEMED_ICONS;
 
-namespace Log {
-extern bool inFile;
+// Records below it are compiled out, e.g. -DLOG_LEVEL=1 drops info.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 0
+#endif
 
+namespace Log {
 constexpr const char* colorOff = "\033[0m";
 constexpr const char* blue = "\033[1;34m";
 constexpr const char* lightBlue = "\033[0;94m";
@@ -32,36 +50,384 @@ constexpr const char* yellow = "\033[0;33m";
 constexpr const char* pink = "\033[0;35m";
 constexpr const char* green = "\033[0;32m";
 
-void info(const std::string& message, const std::source_location& location =
-                                          std::source_location::current());
-void error(const std::string& message, const std::source_location& location =
-                                           std::source_location::current());
-void warn(const std::string& message, const std::source_location& location =
-                                          std::source_location::current());
+enum class Level : uint8_t { Info, Warn, Error };
+constexpr Level minLevel = static_cast<Level>(LOG_LEVEL);
+
+struct Record {
+  Level level;
+  std::time_t time;
+  // Basename. Copied, source_location's string is gone once extension is dlclose'd.
+  std::string file;
+  uint line;
+  std::string message;
+};
+std::string format(const Record& record);
+
+/*
+  Until started, records are printed synchronously e.g. CLI.
+  Daemon starts background writer which keeps LOG_FILE open ("file"), otherwise prints to terminal.
+  Callers only push to lock-free queue.
+*/
+void start(bool file);
+// Writes pending records and joins writer.
+void stop();
+// Last records kept in memory for "logs" command, oldest first.
+std::vector<Record> recent(size_t count);
+
+void write(Level level, std::string&& message,
+           const std::source_location& location);
+
+inline void info(std::string message, const std::source_location& location =
+                                          std::source_location::current()) {
+  if constexpr (Level::Info >= minLevel)
+    write(Level::Info, std::move(message), location);
+}
+inline void warn(std::string message, const std::source_location& location =
+                                          std::source_location::current()) {
+  if constexpr (Level::Warn >= minLevel)
+    write(Level::Warn, std::move(message), location);
+}
+inline void error(std::string message, const std::source_location& location =
+                                           std::source_location::current()) {
+  if constexpr (Level::Error >= minLevel)
+    write(Level::Error, std::move(message), location);
+}
 }
 
+void prepareDirectory(const std::string& path);
+std::string getAbsolutePath(const std::string& path,
+                            const std::string& parent = HOME);
+
+// Blocks until exit. Prefer Process::spawn() in daemon.
+std::string run(const std::string& command);
+// Daemon only, see Process::spawn().
+void runNewProcess(const std::string& command);
+
+// Rate limiting on Scheduler. Timing may slip by "ms" / 10 to share wakeups.
+class Debouncer {
+ public:
+  enum Mode {
+    // Runs once "ms" after first call, calls meanwhile are merged.
+    Throttle,
+    // Runs "ms" after last call.
+    Debounce,
+    // Runs on first call, then ignores calls for "ms".
+    Leading
+  };
+
+ private:
+  std::function<void()> callback;
+  uint job = 0;
+  uint ms;
+  Mode mode;
+  // Guards calls marshalled from other threads against destroyed debouncer.
+  std::shared_ptr<bool> alive = std::make_shared<bool>();
+
+ public:
+  Debouncer(uint ms, const std::function<void()>& callback,
+            Mode mode = Throttle);
+  ~Debouncer();
+  void call();
+  bool pending();
+  void cancel();
+};
+
+/*
+  Work stealing pool. Each worker takes newest job from own queue first, otherwise oldest job of others.
+  Jobs posted from a worker stay on that worker, so nested work keeps cache locality.
+*/
+class ThreadPool {
+  using Job = std::function<void()>;
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable wake;
+  size_t pending = 0;
+  bool stopping = false;
+  std::atomic<size_t> next = 0;
+
+  bool take(size_t worker, Job& job);
+  void loop(size_t worker);
+
+ public:
+  ThreadPool(size_t size = std::max(2u, std::thread::hardware_concurrency()));
+  ~ThreadPool();
+  void post(Job&& job);
+};
+ThreadPool& workers();
+
+// Runs "callback" in GLib main context. Callbacks queued meanwhile run together in one idle dispatch.
+void runOnMain(std::function<void()>&& callback);
+// Thread that loaded system-ui and runs GLib main loop.
+bool isMainThread();
+
+template <typename Result>
+class Task {
+  using Value = std::conditional_t<std::is_void_v<Result>, bool, Result>;
+  using Callback =
+      std::conditional_t<std::is_void_v<Result>, std::function<void()>,
+                         std::function<void(Value)>>;
+  struct Shared {
+    std::mutex mutex;
+    std::optional<Value> value;
+    Callback callback;
+  };
+  std::shared_ptr<Shared> shared;
+
+  static void deliver(const std::shared_ptr<Shared>& shared) {
+    runOnMain([shared]() {
+      if constexpr (std::is_void_v<Result>)
+        shared->callback();
+      else
+        shared->callback(std::move(*shared->value));
+    });
+  }
+
+ public:
+  Task() : shared(std::make_shared<Shared>()) {}
+
+  // Worker side.
+  void resolve(Value&& value) {
+    std::lock_guard lock(shared->mutex);
+    shared->value = std::move(value);
+    if (shared->callback) deliver(shared);
+  }
+
+  // "callback" runs on main thread with result, even if task already finished.
+  void thenOnMain(Callback&& callback) {
+    std::lock_guard lock(shared->mutex);
+    shared->callback = std::move(callback);
+    if (shared->value) deliver(shared);
+  }
+};
+
+// Runs "function" on worker thread, e.g. submit(parse).thenOnMain(render).
+template <typename Function>
+auto submit(Function&& function) {
+  using Result = std::invoke_result_t<Function>;
+  Task<Result> task;
+  workers().post([task, function = std::forward<Function>(function)]() mutable {
+    if constexpr (std::is_void_v<Result>) {
+      function();
+      task.resolve(true);
+    } else
+      task.resolve(function());
+  });
+  return task;
+}
+
+// Milliseconds from first save() to write.
+constexpr uint saveDelay = 500;
+
 template <typename Content>
 class StorageManager {
   std::string file;
   bool loaded = false;
 
+  /*
+    Optional binary copy of "file", faster to parse. JSON stays source of truth, user editable.
+    Layout: int64 JSON modified time, then BEVE content. Stale once JSON's time differs.
+  */
+  std::string cacheFile;
+  // Of file when read last, see reload().
+  int64_t loadedTime = 0;
+
+  int64_t modifiedTime() {
+    std::error_code error;
+    auto time = std::filesystem::last_write_time(file, error);
+    return error ? 0 : time.time_since_epoch().count();
+  }
+
+  bool readCache(int64_t time) {
+    std::ifstream stream(cacheFile, std::ios::binary);
+    if (!stream.is_open()) return false;
+    std::string buffer((std::istreambuf_iterator<char>(stream)),
+                       std::istreambuf_iterator<char>());
+    int64_t cachedTime;
+    if (buffer.size() < sizeof(cachedTime)) return false;
+    std::memcpy(&cachedTime, buffer.data(), sizeof(cachedTime));
+    if (cachedTime != time) return false;
+    buffer.erase(0, sizeof(cachedTime));
+    if (glz::read_beve(content, buffer)) {
+      content = Content{};
+      return false;
+    }
+    return true;
+  }
+
+  void writeCache(const Content& snapshot, int64_t time) {
+    std::string buffer(sizeof(time), '\0');
+    std::memcpy(buffer.data(), &time, sizeof(time));
+    std::string encoded;
+    glz::write_beve(snapshot, encoded);
+    buffer += encoded;
+
+    prepareDirectory(cacheFile);
+    std::string temporary = cacheFile + ".tmp";
+    {
+      std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+      stream << buffer;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, cacheFile, error);
+  }
+
+  // Write-behind. Coalesces saves, then serializes copy on worker.
+  std::unique_ptr<Debouncer> saver;
+  // Newest snapshot wins even if older worker job runs later.
+  uint64_t generation = 0;
+  std::mutex writeMutex;
+  uint64_t writtenGeneration = 0;
+  // JSON on disk as of own last write or reload(), so unchanged save skips write.
+  // Unset until then, serializing on load would slow read-only users e.g. CLI.
+  std::optional<std::string> written;
+  // File's modified time after own last write, so reload() skips own saves unparsed.
+  int64_t writtenTime = 0;
+  // Submitted writes not finished yet, see flush().
+  size_t inFlight = 0;
+  std::condition_variable writeDone;
+
+  static void write(StorageManager* _this, const Content& snapshot,
+                    uint64_t generation) {
+    std::string buffer;
+    glz::write_json(snapshot, buffer);
+    std::lock_guard lock(_this->writeMutex);
+    if (generation <= _this->writtenGeneration) return;
+    _this->writtenGeneration = generation;
+    if (buffer == _this->written) return;
+
+    // Rename is atomic, so crash never leaves partial file.
+    prepareDirectory(_this->file);
+    std::string temporary = _this->file + ".tmp";
+    {
+      std::ofstream stream(temporary, std::ios::trunc);
+      stream << buffer;
+      if (!stream.flush()) {
+        Log::error("StorageManager: Unable to save " + _this->file);
+        return;
+      }
+    }
+    std::error_code renameError;
+    std::filesystem::rename(temporary, _this->file, renameError);
+    if (renameError) {
+      Log::error("StorageManager: Unable to save " + _this->file);
+      return;
+    }
+    _this->written = std::move(buffer);
+    _this->writtenTime = _this->modifiedTime();
+    if (!_this->cacheFile.empty())
+      _this->writeCache(snapshot, _this->writtenTime);
+  }
+
  public:
-  StorageManager(const std::string& file) : file(file) {}
+  StorageManager(const std::string& file, const std::string& cacheFile = "")
+      : file(file), cacheFile(cacheFile) {}
   Content content;
   Content& get() {
     if (loaded) return content;
+    if (!std::filesystem::exists(file)) {
+      // Defaults until first save.
+      loaded = true;
+      return content;
+    }
+    int64_t time = modifiedTime();
+    loadedTime = time;
+    if (!cacheFile.empty() && readCache(time)) {
+      loaded = true;
+      return content;
+    }
     std::string buffer{};
     auto error = glz::read_file_json(content, file, buffer);
     if (error)
       Log::error("StorageManager: Parse failed " + file + "\n" +
                  glz::format_error(error, buffer));
-    else
+    else {
       loaded = true;
+      if (!cacheFile.empty()) {
+        std::lock_guard lock(writeMutex);
+        writeCache(content, time);
+      }
+    }
     return content;
   }
   void save() {
-    auto error = glz::write_file_json(content, file, std::string{});
-    if (error) Log::error("StorageManager: Unable to save " + file);
+    if (!saver)
+      saver = std::make_unique<Debouncer>(saveDelay, [this]() {
+        auto snapshot = std::make_shared<Content>(content);
+        {
+          std::lock_guard lock(writeMutex);
+          inFlight++;
+        }
+        submit([this, snapshot, current = ++generation]() {
+          write(this, *snapshot, current);
+          std::lock_guard lock(writeMutex);
+          inFlight--;
+          writeDone.notify_all();
+        });
+      });
+    saver->call();
+  }
+  /*
+    Re-reads file if changed outside e.g. edited by hand. Own saves don't count.
+    Returns true and old content in "previous" if content differs, so caller can update only what changed.
+  */
+  bool reload(Content& previous) {
+    if (!loaded) return false;
+    int64_t time = modifiedTime();
+    if (time == loadedTime) return false;
+    loadedTime = time;
+    {
+      std::lock_guard lock(writeMutex);
+      if (time == writtenTime) return false;
+    }
+
+    Content fresh;
+    std::string buffer{};
+    auto error = glz::read_file_json(fresh, file, buffer);
+    if (error) {
+      Log::error("StorageManager: Parse failed " + file + "\n" +
+                 glz::format_error(error, buffer));
+      return false;
+    }
+    std::string freshJson, currentJson;
+    glz::write_json(fresh, freshJson);
+    {
+      // Own write, content may be newer already.
+      std::lock_guard lock(writeMutex);
+      if (freshJson == written) return false;
+    }
+    glz::write_json(content, currentJson);
+    if (freshJson == currentJson) return false;
+
+    previous = std::move(content);
+    content = std::move(fresh);
+    // Worker's write() writes same cache files.
+    std::lock_guard lock(writeMutex);
+    written = std::move(freshJson);
+    if (!cacheFile.empty()) writeCache(content, time);
+    return true;
+  }
+
+  /*
+    Writes pending save now and waits for submitted ones, e.g. before exit or exec.
+    Pool drops queued jobs on exit, so those can't be left to run.
+  */
+  void flush() {
+    if (!saver) return;
+    bool pending = saver->pending();
+    saver->cancel();
+    {
+      std::lock_guard lock(writeMutex);
+      pending |= inFlight > 0;
+    }
+    // Newest generation, so submitted jobs finishing later skip.
+    if (pending) write(this, content, ++generation);
+    std::unique_lock lock(writeMutex);
+    writeDone.wait(lock, [this]() { return inFlight == 0; });
   }
 };
 
@@ -69,28 +435,19 @@ struct AppData {
   bool lightMode = false;
   using Theme = std::map<std::string, std::string>;
   std::vector<std::string> pinnedApps;
+  // Seed "theme" was generated from, tones are regenerated from it e.g. on mode change.
+  std::string color;
   Theme theme;
 };
 
-struct UserConfig {};
+struct UserConfig {
+  // Daemon socket pending connections.
+  int socketBacklog = 128;
+  // Milliseconds to receive rest of partially sent request.
+  uint socketReadTimeout = 2000;
+  // Milliseconds main loop may stay busy before logged with backtrace. 0 disables.
+  uint stallBudget = 8;
+};
 
 extern StorageManager<AppData> appData;
 extern StorageManager<UserConfig> userConfig;
-
-void prepareDirectory(const std::string& path);
-std::string getAbsolutePath(const std::string& path,
-                            const std::string& parent = HOME);
-
-std::string run(const std::string& command);
-void runNewProcess(const std::string& command);
-
-class Debouncer {
-  std::function<void()> callback;
-  uint interval = 0;
-  uint ms;
-
- public:
-  Debouncer(uint ms, const std::function<void()>& callback);
-  ~Debouncer();
-  void call();
-};
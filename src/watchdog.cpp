@@ -0,0 +1,217 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#include "watchdog.h"
+
+#include <execinfo.h>
+#include <glib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+#include "metrics.h"
+#include "utils.h"
+
+namespace Watchdog {
+constexpr int maxFrames = 32;
+// Handler and signal trampoline.
+constexpr int skipFrames = 2;
+
+GPollFunc defaultPoll = nullptr;
+int64_t budgetUs = 0;
+pthread_t mainThread;
+std::thread thread;
+std::mutex mutex;
+std::condition_variable wake;
+bool running = false;
+
+// Set after poll returns, 0 while polling.
+std::atomic<int64_t> busySince = 0;
+std::atomic<uint64_t> iteration = 0;
+// Iteration watchdog interrupted, so one sample per stall.
+uint64_t requested = 0;
+
+// Ready descriptors of last poll, i.e. what woke the loop. Plain storage, only main thread touches it.
+constexpr size_t maxReady = 4;
+int readyFds[maxReady];
+size_t readyCount = 0;
+
+// Written by signal handler on main thread, read there after dispatch.
+struct Sample {
+  std::atomic<uint64_t> iteration = 0;
+  int64_t time;
+  // Source being dispatched, referenced until reported.
+  GSource* source = nullptr;
+  void* frames[maxFrames];
+  int frameCount;
+} sample;
+
+int stallSignal() { return SIGRTMIN; }
+
+int64_t monotonicUs() {
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1000000ll + time.tv_nsec / 1000;
+}
+
+/*
+  Async signal safe only: clock_gettime, backtrace(), g_main_current_source() reading thread local
+  dispatch stack and g_source_ref() incrementing atomically. Both lazy inits are warmed up in start().
+  Nothing taking context lock, e.g. g_source_get_id(), which deadlocks if signal lands while it's held.
+*/
+void onSignal(int) {
+  // Raced with end of iteration, or previous sample not reported yet.
+  if (!busySince.load() || sample.source) return;
+  int savedErrno = errno;
+  sample.time = monotonicUs();
+  sample.source = g_main_current_source();
+  if (sample.source) g_source_ref(sample.source);
+  sample.frameCount = backtrace(sample.frames, maxFrames);
+  sample.iteration.store(iteration.load());
+  errno = savedErrno;
+}
+
+bool isGlib(const char* symbol) {
+  return strstr(symbol, "libglib-2.0") || strstr(symbol, "libgobject-2.0");
+}
+
+// Callback GLib was dispatching, i.e. first frame inward from g_main_dispatch outside GLib.
+std::string dispatched(char** symbols, int count) {
+  for (int index = skipFrames; index < count; index++) {
+    if (!strstr(symbols[index], "g_main_context_dispatch") &&
+        !strstr(symbols[index], "g_main_dispatch"))
+      continue;
+    for (int inner = index - 1; inner >= skipFrames; inner--)
+      if (!isGlib(symbols[inner])) return symbols[inner];
+  }
+  return "unknown callback";
+}
+
+std::string readyDescriptors() {
+  if (!readyCount) return "timeout or idle";
+  std::string result;
+  for (size_t index = 0; index < readyCount; index++) {
+    std::string link = "/proc/self/fd/" + std::to_string(readyFds[index]);
+    char target[128];
+    ssize_t size = readlink(link.c_str(), target, sizeof(target) - 1);
+    if (!result.empty()) result += ", ";
+    result += "fd " + std::to_string(readyFds[index]);
+    if (size > 0) result += " " + std::string(target, size);
+  }
+  return result;
+}
+
+// Name given by g_source_set_name_by_id(), GDK and GDBus name theirs too.
+std::string sourceName(GSource* source) {
+  if (!source) return "no source";
+  const char* name = g_source_get_name(source);
+  return name ? "source \"" + std::string(name) + "\"" : "unnamed source";
+}
+
+void report(int64_t since, int64_t now) {
+  static Metrics::Counter& stalls = Metrics::counter("main_loop_stalls_total");
+  stalls.add();
+  char** symbols = backtrace_symbols(sample.frames, sample.frameCount);
+  std::string message =
+      "Main loop stalled " + std::to_string((now - since) / 1000) + " ms, in " +
+      sourceName(sample.source) + " (" +
+      (symbols ? dispatched(symbols, sample.frameCount) : "unknown callback") +
+      ")" +
+      " at " + std::to_string((sample.time - since) / 1000) +
+      " ms, woken by " + readyDescriptors();
+  if (symbols) {
+    for (int index = skipFrames; index < sample.frameCount; index++)
+      message += "\n  " + std::string(symbols[index]);
+    free(symbols);
+  }
+  if (sample.source) g_source_unref(sample.source);
+  sample.source = nullptr;
+  Log::warn(message);
+}
+
+gint poll(GPollFD* fds, guint count, gint timeout) {
+  int64_t since = busySince.exchange(0);
+  if (since && sample.iteration.load() == iteration.load())
+    report(since, monotonicUs());
+  gint result = defaultPoll(fds, count, timeout);
+  readyCount = 0;
+  for (guint index = 0; index < count && readyCount < maxReady; index++)
+    if (fds[index].revents) readyFds[readyCount++] = fds[index].fd;
+  iteration.fetch_add(1);
+  busySince.store(monotonicUs());
+  // Locked, so watchdog can't miss it between checking and waiting.
+  { std::lock_guard lock(mutex); }
+  wake.notify_one();
+  return result;
+}
+
+void loop() {
+  std::unique_lock lock(mutex);
+  while (running) {
+    // No wakeups while idle in poll or stall already sampled, poll() notifies on next iteration.
+    wake.wait(lock, []() {
+      return !running || (busySince.load() && iteration.load() != requested);
+    });
+    if (!running) break;
+    uint64_t current = iteration.load();
+    int64_t since = busySince.load();
+    if (!since) continue;
+    int64_t left = since + budgetUs - monotonicUs();
+    if (left > 0) {
+      // Notified early if iteration ends and next starts.
+      wake.wait_for(lock, std::chrono::microseconds(left));
+      continue;
+    }
+    requested = current;
+    pthread_kill(mainThread, stallSignal());
+  }
+}
+
+void start(uint budget) {
+  if (running || !budget) return;
+  budgetUs = budget * 1000ll;
+  mainThread = pthread_self();
+
+  // First call loads libgcc, which isn't safe in handler.
+  void* frames[1];
+  backtrace(frames, 1);
+  // Same for GLib's dispatch stack key.
+  g_main_current_source();
+
+  struct sigaction action = {};
+  action.sa_handler = onSignal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(stallSignal(), &action, nullptr);
+
+  GMainContext* context = g_main_context_default();
+  defaultPoll = g_main_context_get_poll_func(context);
+  g_main_context_set_poll_func(context, poll);
+
+  running = true;
+  thread = std::thread(loop);
+}
+
+void stop() {
+  if (!running) return;
+  {
+    std::lock_guard lock(mutex);
+    running = false;
+  }
+  wake.notify_one();
+  thread.join();
+  g_main_context_set_poll_func(g_main_context_default(), defaultPoll);
+  signal(stallSignal(), SIG_IGN);
+  if (sample.source) g_source_unref(sample.source);
+  sample.source = nullptr;
+}
+}
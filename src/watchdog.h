@@ -0,0 +1,19 @@
+// Copyright © 2024 Rakib <rakib13332@gmail.com>
+// Repo: https://github.com/rakibdev/system-ui
+// SPDX-License-Identifier: MPL-2.0
+
+#pragma once
+
+#include <sys/types.h>
+
+/*
+  Main loop stall detector. Times work between polls of default GLib context, i.e. source dispatches.
+  Once "budget" ms pass, watchdog thread interrupts main thread to record dispatching GSource and backtrace,
+  logged as warning when iteration ends with source name, callback and descriptors that woke loop.
+  Watchdog thread sleeps while loop is idle in poll.
+*/
+namespace Watchdog {
+// Main thread, before loop runs. 0 "budget" disables.
+void start(uint budget);
+void stop();
+}
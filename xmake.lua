@@ -3,7 +3,14 @@ set_defaultmode("debug")
 add_rules("mode.debug", "mode.release")
 if is_mode("debug") then add_defines("DEV") end
 
-add_requires("gtk+-3.0", "gtk-layer-shell-0", "libpipewire-0.3", "glaze", {system = true})
+option("tracing")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Record spans for \"system-ui trace\". Compiled out otherwise.")
+option_end()
+if has_config("tracing") then add_defines("TRACING") end
+
+add_requires("gtk+-3.0", "gtk-layer-shell-0", "libpipewire-0.3", "glib-2.0", "glaze", {system = true})
 
 set_installdir("/usr/")
 local pcFile = "/lib/pkgconfig/system-ui.pc"
@@ -34,6 +41,7 @@ target("material-color-utilities")
 target("system-ui")
     set_kind("shared")
     add_files("src/**.cpp")
+    remove_files("src/client.cpp")
     add_files("extensions/**.cpp")
 
     add_packages("gtk+-3.0", "gtk-layer-shell-0", "libpipewire-0.3", "glaze")
@@ -74,4 +82,10 @@ target("app")
     set_basename("system-ui")
     add_deps("system-ui")
     -- LD_LIBRARY_PATH
-    add_rpathdirs("@loader_path")
\ No newline at end of file
+    add_rpathdirs("@loader_path")
+
+-- Slim CLI for keybindings. Only links glib, so it starts faster than "system-ui".
+target("client")
+    set_basename("system-ui-client")
+    add_files("src/client.cpp", "src/ipc.cpp", "src/utils.cpp", "src/scheduler.cpp", "src/actions/patch.cpp")
+    add_packages("glib-2.0", "glaze")